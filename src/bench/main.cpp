@@ -0,0 +1,466 @@
+// wglib_bench: runs the demo scenarios headless for a fixed number of frames
+// and reports frame-time statistics as JSON. The engine logs to stdout, so the
+// report is printed last, or written to the file given with --out.
+//
+// With --sort N it also sorts N random key-value pairs with RadixSortLayer every
+// frame and compares the throughput to std::sort.
+//
+// Usage: wglib_bench [--frames N] [--warmup N] [--hardware] [--no-batching] [--sort N] [--out FILE] [scenario...]
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <print>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lib/CoreEngine.hpp"
+#include "lib/FrameStats.hpp"
+#include "lib/compute/ComputeGraph.hpp"
+#include "lib/compute/Primitives/RadixSort.hpp"
+#include "lib/compute/Readback.hpp"
+#include "lib/compute/ReadbackLayer.hpp"
+#include "scenarios/Scenarios.hpp"
+#include "webgpu/webgpu_cpp.h"
+
+namespace
+{
+struct BenchOptions
+{
+    uint32_t frames{100};
+    uint32_t warmup{10};
+    bool hardware{false};
+    bool batching{true};
+    // Keys of the sort benchmark, none to skip it
+    uint32_t sortKeys{0};
+    std::string_view out{};
+    std::vector<std::string_view> scenarios{"particles", "conway", "interaction", "compute_and_drawing",
+                                           "shapes"};
+};
+
+auto parseCount(std::string_view text, uint32_t &out) -> bool
+{
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc{} and ptr == text.data() + text.size();
+}
+
+auto parseArgs(int argc, char **argv, BenchOptions &options) -> bool
+{
+    std::vector<std::string_view> scenarios;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if ((arg == "--frames" or arg == "--warmup") and i + 1 < argc)
+        {
+            if (not parseCount(argv[++i], arg == "--frames" ? options.frames : options.warmup))
+            {
+                std::println(stderr, "Invalid count for {}", arg);
+                return false;
+            }
+        }
+        else if (arg == "--sort" and i + 1 < argc)
+        {
+            if (not parseCount(argv[++i], options.sortKeys))
+            {
+                std::println(stderr, "Invalid count for {}", arg);
+                return false;
+            }
+        }
+        else if (arg == "--out" and i + 1 < argc)
+        {
+            options.out = argv[++i];
+        }
+        else if (arg == "--hardware")
+        {
+            options.hardware = true;
+        }
+        else if (arg == "--no-batching")
+        {
+            options.batching = false;
+        }
+        else if (wglib::scenarios::findScenario(arg))
+        {
+            scenarios.push_back(arg);
+        }
+        else
+        {
+            std::println(stderr, "Unknown argument: {}", arg);
+            return false;
+        }
+    }
+    if (not scenarios.empty())
+    {
+        options.scenarios = std::move(scenarios);
+    }
+    return true;
+}
+
+auto formatSummary(std::string &json, std::string_view key, const wglib::TimingSummary &summary, bool last) -> void
+{
+    std::format_to(std::back_inserter(json),
+                   R"(      "{}": {{"mean": {:.4f}, "p50": {:.4f}, "p95": {:.4f}, "p99": {:.4f}, "max": {:.4f}}}{})"
+                   "\n",
+                   key, summary.mean, summary.p50, summary.p95, summary.p99, summary.max, last ? "" : ",");
+}
+
+auto runScenario(std::string &json, const wglib::scenarios::Scenario &scenario, const BenchOptions &options,
+                 bool last) -> void
+{
+    wglib::Engine engine(scenario.size, scenario.title,
+                         {.headless = true,
+                          .softwareAdapter = not options.hardware,
+                          .frameCount = options.warmup + options.frames,
+                          .collectFrameStats = true});
+    engine.SetBatchingEnabled(options.batching);
+    scenario.setup(engine);
+    engine.Start();
+
+    std::vector<double> cpu, gpu;
+    const auto timings = engine.GetFrameStats()->Timings();
+    for (size_t i = options.warmup; i < timings.size(); ++i)
+    {
+        cpu.push_back(timings[i].cpuMs);
+        gpu.push_back(timings[i].gpuMs);
+    }
+
+    auto out = std::back_inserter(json);
+    std::format_to(out, "    {{\n");
+    std::format_to(out, R"(      "name": "{}",)" "\n", scenario.name);
+    std::format_to(out, R"(      "frames": {},)" "\n", cpu.size());
+    const auto &renderStats = engine.GetRenderStats();
+    std::format_to(out, R"(      "last_frame_draw_calls": {},)" "\n", renderStats.drawCalls);
+    std::format_to(out, R"(      "last_frame_state_changes": {},)" "\n", renderStats.stateChanges);
+    std::format_to(out, R"(      "last_frame_state_changes_skipped": {},)" "\n", renderStats.stateChangesSkipped);
+    std::format_to(out, R"(      "last_frame_bytes_uploaded": {},)" "\n", renderStats.bytesUploaded);
+    std::format_to(out, R"(      "pool_buffers": {},)" "\n", engine.GetBufferPool().Stats().buffers);
+    std::format_to(out, R"(      "render_pipelines": {},)" "\n", engine.GetPipelineCache().Stats().renderPipelines);
+    formatSummary(json, "cpu_ms", wglib::FrameStats::Summarize(std::move(cpu)), false);
+    formatSummary(json, "gpu_ms", wglib::FrameStats::Summarize(std::move(gpu)), true);
+    std::format_to(out, "    }}{}\n", last ? "" : ",");
+}
+
+// The keys and values of the sort benchmark. Every run copies them from the
+// buffers they were uploaded to once into the buffers the sort overwrites, so
+// the upload never reaches the timed passes. Output 0 is the keys, output 1
+// the values.
+class SortInputLayer : public wglib::compute::ComputeLayer<const wglib::compute::SortBuffers &>
+{
+    std::vector<uint32_t> m_keys, m_values;
+    wglib::compute::SortBuffers m_uploaded, m_sorted;
+
+  public:
+    SortInputLayer(std::vector<uint32_t> keys, std::vector<uint32_t> values)
+        : m_keys(std::move(keys)), m_values(std::move(values))
+    {
+    }
+
+  protected:
+    auto getResultImpl() -> const wglib::compute::SortBuffers & override
+    {
+        return m_sorted;
+    }
+
+    auto InitImpl(wgpu::Device &device) -> void override
+    {
+        const auto count = static_cast<uint32_t>(m_keys.size());
+        for (auto *buffers : {&m_uploaded, &m_sorted})
+        {
+            *buffers = {.keys = wglib::compute::createPrimitiveBuffer<uint32_t>(device, count),
+                        .values = wglib::compute::createPrimitiveBuffer<uint32_t>(device, count)};
+        }
+        auto queue = device.GetQueue();
+        queue.WriteBuffer(m_uploaded.keys, 0, m_keys.data(), m_keys.size() * sizeof(uint32_t));
+        queue.WriteBuffer(m_uploaded.values, 0, m_values.data(), m_values.size() * sizeof(uint32_t));
+        m_keys = {};
+        m_values = {};
+    }
+
+    auto DeclareImpl(wglib::RenderGraph::PassBuilder &builder) -> void override
+    {
+        builder.Write(builder.Import("SortInputKeys", m_sorted.keys));
+        builder.Write(builder.Import("SortInputValues", m_sorted.values));
+    }
+
+    auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &) -> void override
+    {
+        e.CopyBufferToBuffer(m_uploaded.keys, 0, m_sorted.keys, 0, m_sorted.keys.GetSize());
+        e.CopyBufferToBuffer(m_uploaded.values, 0, m_sorted.values, 0, m_sorted.values.GetSize());
+    }
+
+    auto OutputImpl() const -> wglib::compute::ComputeOutput override
+    {
+        return {.buffer = m_sorted.keys};
+    }
+
+    auto AdditionalOutputImpl(uint32_t output) const -> wglib::compute::ComputeOutput override
+    {
+        return output == 1 ? wglib::compute::ComputeOutput{.buffer = m_sorted.values}
+                           : wglib::compute::ComputeOutput{};
+    }
+};
+
+// Runs a RadixSortLayer between two timestamp writes, so its result is the GPU
+// time of the sort's passes alone, in milliseconds: no upload, render pass or
+// wait in the queue. nullopt without the TimestampQuery feature, or when the
+// timestamps are not read back yet.
+class TimedSortLayer : public wglib::compute::ComputeLayer<std::optional<double>>
+{
+    wglib::compute::RadixSortLayer m_sort;
+    wgpu::QuerySet m_timestamps;
+    wgpu::Buffer m_resolved;
+    wglib::compute::ReadbackRing m_readback;
+
+    auto sort() -> wglib::compute::IComputeLayer &
+    {
+        return m_sort;
+    }
+
+    auto sort() const -> const wglib::compute::IComputeLayer &
+    {
+        return m_sort;
+    }
+
+    // An empty pass that only writes a timestamp
+    auto writeTimestamp(wgpu::CommandEncoder &e, const wgpu::PassTimestampWrites &writes) -> void
+    {
+        const wgpu::ComputePassDescriptor descriptor{.timestampWrites = &writes};
+        e.BeginComputePass(&descriptor).End();
+    }
+
+  public:
+    explicit TimedSortLayer(uint32_t capacity) : m_sort(capacity, true)
+    {
+    }
+
+  protected:
+    auto getResultImpl() -> std::optional<double> override
+    {
+        if (not m_timestamps)
+        {
+            return std::nullopt;
+        }
+        const auto ticks = m_readback.Take<uint64_t>();
+        if (not ticks or (*ticks)[1] < (*ticks)[0])
+        {
+            return std::nullopt;
+        }
+        // Timestamps are in nanoseconds
+        return static_cast<double>((*ticks)[1] - (*ticks)[0]) / 1e6;
+    }
+
+    auto InitImpl(wgpu::Device &device) -> void override
+    {
+        sort().Init(device);
+        if (not device.HasFeature(wgpu::FeatureName::TimestampQuery))
+        {
+            return;
+        }
+        const wgpu::QuerySetDescriptor querySet{.type = wgpu::QueryType::Timestamp, .count = 2};
+        m_timestamps = device.CreateQuerySet(&querySet);
+        const wgpu::BufferDescriptor resolved{.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc,
+                                              .size = 2 * sizeof(uint64_t)};
+        m_resolved = device.CreateBuffer(&resolved);
+        m_readback.Init(device, resolved.size, 2);
+    }
+
+    auto DeclareImpl(wglib::RenderGraph::PassBuilder &builder) -> void override
+    {
+        sort().Declare(builder);
+    }
+
+    auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void override
+    {
+        if (not m_timestamps)
+        {
+            sort().Compute(e, q, 1);
+            return;
+        }
+        writeTimestamp(e, {.querySet = m_timestamps, .beginningOfPassWriteIndex = 0});
+        sort().Compute(e, q, 1);
+        writeTimestamp(e, {.querySet = m_timestamps, .endOfPassWriteIndex = 1});
+        e.ResolveQuerySet(m_timestamps, 0, 2, m_resolved, 0);
+        m_readback.Record(e, m_resolved);
+    }
+
+    auto SubmittedImpl() -> void override
+    {
+        sort().Submitted();
+        if (m_timestamps)
+        {
+            m_readback.Submitted();
+        }
+    }
+
+    auto OutputImpl() const -> wglib::compute::ComputeOutput override
+    {
+        return sort().Output(0);
+    }
+
+    auto SetInputImpl(uint32_t slot, const wglib::compute::ComputeOutput &input) -> void override
+    {
+        sort().SetInput(slot, input);
+    }
+};
+
+// Sorts the same random key-value pairs with RadixSortLayer once per frame
+// and with std::sort, and reports both in keys per second. With the
+// TimestampQuery feature the GPU time is that of the sort's passes; without
+// it, that of the whole frame, which also copies the keys and values into
+// place and renders. The first frame reads the sorted keys and values back:
+// the keys must match std::sort, and the values, each key's original index,
+// must match std::stable_sort, which shows every pass kept equal keys in
+// order.
+auto runSortBenchmark(std::string &json, const BenchOptions &options) -> void
+{
+    using Clock = std::chrono::steady_clock;
+    using Readback = wglib::compute::ReadbackLayer<uint32_t>;
+    using View = std::optional<wglib::compute::ReadbackView<uint32_t>>;
+    constexpr uint32_t CPU_RUNS = 5;
+
+    std::mt19937 rng{42};
+    std::vector<uint32_t> keys(options.sortKeys);
+    std::ranges::generate(keys, [&] { return static_cast<uint32_t>(rng()); });
+    std::vector<uint32_t> values(keys.size());
+    std::iota(values.begin(), values.end(), 0u);
+
+    std::vector<double> cpu;
+    std::vector<uint32_t> expectedKeys;
+    for (uint32_t run = 0; run < CPU_RUNS; ++run)
+    {
+        expectedKeys = keys;
+        const auto start = Clock::now();
+        std::sort(expectedKeys.begin(), expectedKeys.end());
+        cpu.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    auto expectedValues = values;
+    std::ranges::stable_sort(expectedValues, {}, [&](uint32_t index) { return keys[index]; });
+
+    // One frame in flight, so a frame's GPU time never includes waiting for
+    // the one before
+    wglib::Engine engine({512, 512}, "sort",
+                         {.headless = true,
+                          .softwareAdapter = not options.hardware,
+                          .frameCount = options.warmup + options.frames,
+                          .collectFrameStats = true,
+                          .framesInFlight = 1,
+                          .timestampQuery = true});
+    const auto count = static_cast<uint32_t>(keys.size());
+    auto input = engine.InitComputeLayer<SortInputLayer>(std::move(keys), std::move(values));
+
+    std::optional<bool> keysMatch, valuesMatch;
+    auto check = [](std::vector<uint32_t> expected, std::optional<bool> &matches) {
+        return [expected = std::move(expected), &matches](View result) {
+            matches = result and result->size() >= expected.size() and
+                      std::ranges::equal(result->Span().first(expected.size()), expected);
+        };
+    };
+    wglib::compute::ComputeGraph checked;
+    auto checkedInput = checked.Add(input);
+    auto sort = checked.Add(engine.InitComputeLayer<wglib::compute::RadixSortLayer>(count, true));
+    checked.Connect(checkedInput, sort, 0);
+    checked.ConnectOutput(checkedInput, 1, sort, 1);
+    auto keysReadback = checked.Add(engine.InitComputeLayer<Readback>());
+    auto valuesReadback = checked.Add(engine.InitComputeLayer<Readback>());
+    checked.Connect(sort, keysReadback);
+    checked.ConnectOutput(sort, 1, valuesReadback);
+    checked.OnComplete(keysReadback, check(std::move(expectedKeys), keysMatch));
+    checked.OnComplete(valuesReadback, check(std::move(expectedValues), valuesMatch));
+
+    std::vector<double> sortMs;
+    wglib::compute::ComputeGraph timed;
+    auto timedInput = timed.Add(input);
+    auto timedSort = timed.Add(engine.InitComputeLayer<TimedSortLayer>(count));
+    timed.Connect(timedInput, timedSort, 0);
+    timed.ConnectOutput(timedInput, 1, timedSort, 1);
+    timed.OnComplete(timedSort, [&](std::optional<double> ms) {
+        if (ms)
+        {
+            sortMs.push_back(*ms);
+        }
+    });
+
+    engine.OnUpdate([&, first = true](auto) mutable {
+        engine.PushComputeGraph(std::exchange(first, false) ? checked : timed);
+    });
+    engine.Start();
+
+    const auto timestamps = not sortMs.empty();
+    std::vector<double> gpu;
+    if (timestamps)
+    {
+        gpu.assign(sortMs.begin() + std::min<size_t>(options.warmup, sortMs.size() - 1), sortMs.end());
+    }
+    else
+    {
+        const auto timings = engine.GetFrameStats()->Timings();
+        for (size_t i = options.warmup; i < timings.size(); ++i)
+        {
+            gpu.push_back(timings[i].gpuMs);
+        }
+    }
+    const auto gpuSummary = wglib::FrameStats::Summarize(std::move(gpu));
+    const auto cpuSummary = wglib::FrameStats::Summarize(std::move(cpu));
+    const auto keysPerSecond = [&](double ms) { return ms > 0 ? count * 1000.0 / ms : 0.0; };
+
+    auto out = std::back_inserter(json);
+    std::format_to(out, R"(  "sort": {{)" "\n");
+    std::format_to(out, R"(    "keys": {},)" "\n", count);
+    std::format_to(out, R"(    "matches_std_sort": {},)" "\n", keysMatch.value_or(false));
+    std::format_to(out, R"(    "values_match_stable_sort": {},)" "\n", valuesMatch.value_or(false));
+    std::format_to(out, R"(    "radix_sort_timing": "{}",)" "\n", timestamps ? "timestamp_query" : "frame");
+    std::format_to(out, R"(    "radix_sort_keys_per_second": {:.0f},)" "\n", keysPerSecond(gpuSummary.p50));
+    std::format_to(out, R"(    "std_sort_keys_per_second": {:.0f},)" "\n", keysPerSecond(cpuSummary.p50));
+    formatSummary(json, "radix_sort_ms", gpuSummary, false);
+    formatSummary(json, "std_sort_ms", cpuSummary, true);
+    std::format_to(out, "  }}\n");
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (not parseArgs(argc, argv, options))
+    {
+        return 1;
+    }
+
+    std::string json;
+    auto out = std::back_inserter(json);
+    std::format_to(out, "{{\n");
+    std::format_to(out, R"(  "adapter": "{}",)" "\n", options.hardware ? "hardware" : "software");
+    std::format_to(out, R"(  "warmup": {},)" "\n", options.warmup);
+    std::format_to(out, R"(  "batching": {},)" "\n", options.batching);
+    std::format_to(out, R"(  "scenarios": [)" "\n");
+    for (size_t i = 0; i < options.scenarios.size(); ++i)
+    {
+        runScenario(json, *wglib::scenarios::findScenario(options.scenarios[i]), options,
+                    i + 1 == options.scenarios.size());
+    }
+    std::format_to(out, "  ]{}\n", options.sortKeys > 0 ? "," : "");
+    if (options.sortKeys > 0)
+    {
+        runSortBenchmark(json, options);
+    }
+    std::format_to(out, "}}\n");
+
+    if (options.out.empty())
+    {
+        std::print("{}", json);
+        return 0;
+    }
+    std::ofstream file{std::string(options.out)};
+    if (not file)
+    {
+        std::println(stderr, "Could not open {}", options.out);
+        return 1;
+    }
+    file << json;
+}
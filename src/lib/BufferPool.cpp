@@ -0,0 +1,174 @@
+#include "BufferPool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+namespace
+{
+auto registry() -> std::unordered_map<WGPUDevice, std::shared_ptr<BufferPool>> &
+{
+    static std::unordered_map<WGPUDevice, std::shared_ptr<BufferPool>> pools;
+    return pools;
+}
+} // namespace
+
+BufferAllocation::BufferAllocation(BufferAllocation &&other) noexcept
+    : m_pool(std::move(other.m_pool)), m_buffer(std::move(other.m_buffer)), m_offset(other.m_offset),
+      m_size(other.m_size), m_page(other.m_page), m_size_class(other.m_size_class)
+{
+    other.m_buffer = nullptr;
+}
+
+auto BufferAllocation::operator=(BufferAllocation &&other) noexcept -> BufferAllocation &
+{
+    if (this != &other)
+    {
+        Reset();
+        m_pool = std::move(other.m_pool);
+        m_buffer = std::move(other.m_buffer);
+        m_offset = other.m_offset;
+        m_size = other.m_size;
+        m_page = other.m_page;
+        m_size_class = other.m_size_class;
+        other.m_buffer = nullptr;
+    }
+    return *this;
+}
+
+BufferAllocation::~BufferAllocation()
+{
+    Reset();
+}
+
+auto BufferAllocation::Reset() -> void
+{
+    if (m_pool and m_buffer)
+    {
+        m_pool->retire(*this);
+    }
+    m_pool.reset();
+    m_buffer = nullptr;
+    m_offset = m_size = 0;
+}
+
+BufferPool::BufferPool(wgpu::Device device) : m_device(std::move(device))
+{
+}
+
+auto BufferPool::Get(const wgpu::Device &device) -> BufferPool &
+{
+    auto &pool = registry()[device.Get()];
+    if (not pool)
+    {
+        pool = std::make_shared<BufferPool>(device);
+    }
+    return *pool;
+}
+
+auto BufferPool::Release(const wgpu::Device &device) -> void
+{
+    const auto it = registry().find(device.Get());
+    if (it == registry().end())
+    {
+        return;
+    }
+    it->second->m_detached = true;
+    it->second->reclaim(it->second->m_retired);
+    registry().erase(it);
+}
+
+auto BufferPool::Allocate(uint64_t size) -> BufferAllocation
+{
+    BufferAllocation allocation;
+    allocation.m_pool = shared_from_this();
+    ++m_stats.liveAllocations;
+
+    if (size > MAX_BLOCK_SIZE)
+    {
+        allocation.m_buffer = util::createBuffer<uint32_t, USAGE>(m_device, util::divCeil<uint64_t>(size, 4));
+        allocation.m_size = allocation.m_buffer.GetSize();
+        allocation.m_size_class = DEDICATED;
+        ++m_stats.buffers;
+        m_stats.bytesReserved += allocation.m_size;
+        return allocation;
+    }
+
+    const auto blockSize = std::bit_ceil(std::max(size, MIN_BLOCK_SIZE));
+    const auto sizeClass = static_cast<uint32_t>(std::countr_zero(blockSize / MIN_BLOCK_SIZE));
+    auto &freeBlocks = m_free_blocks[sizeClass];
+    if (freeBlocks.empty())
+    {
+        // Carve a new page into blocks of this class, lowest offset handed out first
+        const auto page = static_cast<uint32_t>(m_pages.size());
+        m_pages.push_back(util::createBuffer<uint32_t, USAGE>(m_device, PAGE_SIZE / sizeof(uint32_t)));
+        ++m_stats.buffers;
+        m_stats.bytesReserved += PAGE_SIZE;
+        for (auto offset = PAGE_SIZE; offset > 0; offset -= blockSize)
+        {
+            freeBlocks.push_back({.page = page, .offset = offset - blockSize});
+        }
+    }
+
+    const auto block = freeBlocks.back();
+    freeBlocks.pop_back();
+    allocation.m_buffer = m_pages[block.page];
+    allocation.m_offset = block.offset;
+    allocation.m_size = blockSize;
+    allocation.m_page = block.page;
+    allocation.m_size_class = sizeClass;
+    return allocation;
+}
+
+auto BufferPool::retire(const BufferAllocation &allocation) -> void
+{
+    m_retired.push_back({
+        .block = {.page = allocation.m_page, .offset = allocation.m_offset},
+        .sizeClass = allocation.m_size_class,
+        .buffer = allocation.m_size_class == DEDICATED ? allocation.m_buffer : nullptr,
+    });
+    ++m_stats.pendingFrees;
+    if (m_detached)
+    {
+        reclaim(m_retired);
+    }
+}
+
+auto BufferPool::reclaim(std::vector<Retired> &retired) -> void
+{
+    for (const auto &r : retired)
+    {
+        if (r.sizeClass == DEDICATED)
+        {
+            --m_stats.buffers;
+            m_stats.bytesReserved -= r.buffer.GetSize();
+        }
+        else
+        {
+            m_free_blocks[r.sizeClass].push_back(r.block);
+        }
+    }
+    m_stats.liveAllocations -= static_cast<uint32_t>(retired.size());
+    m_stats.pendingFrees -= static_cast<uint32_t>(retired.size());
+    retired.clear();
+}
+
+auto BufferPool::EndFrame(FramePacer &pacer) -> void
+{
+    if (m_retired.empty())
+    {
+        return;
+    }
+    pacer.Defer([pool = shared_from_this(), retired = std::move(m_retired)]() mutable { pool->reclaim(retired); });
+    m_retired.clear();
+}
+
+auto BufferPool::Stats() const -> BufferPoolStats
+{
+    return m_stats;
+}
+} // namespace wglib
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "FramePacer.hpp"
+
+namespace wglib
+{
+class BufferPool;
+
+struct BufferPoolStats
+{
+    // GPU buffer objects owned by the pool, pages and dedicated buffers
+    size_t buffers{0};
+    uint64_t bytesReserved{0};
+    uint32_t liveAllocations{0};
+    // Freed blocks waiting for their last frame to complete
+    uint32_t pendingFrees{0};
+};
+
+// A block of a pooled buffer: bind with Buffer() at Offset(). Returned to the
+// pool when reset, reassigned or destroyed; the block is reused only after
+// the frame that freed it has completed.
+class BufferAllocation
+{
+    friend BufferPool;
+
+    std::shared_ptr<BufferPool> m_pool;
+    wgpu::Buffer m_buffer;
+    uint64_t m_offset{0};
+    uint64_t m_size{0};
+    uint32_t m_page{0};
+    uint32_t m_size_class{0};
+
+  public:
+    BufferAllocation() = default;
+    BufferAllocation(const BufferAllocation &) = delete;
+    auto operator=(const BufferAllocation &) -> BufferAllocation & = delete;
+    BufferAllocation(BufferAllocation &&other) noexcept;
+    auto operator=(BufferAllocation &&other) noexcept -> BufferAllocation &;
+    ~BufferAllocation();
+
+    auto Reset() -> void;
+
+    auto Buffer() const -> const wgpu::Buffer &
+    {
+        return m_buffer;
+    }
+
+    auto Offset() const -> uint64_t
+    {
+        return m_offset;
+    }
+
+    // Usable bytes, at least the requested size
+    auto Size() const -> uint64_t
+    {
+        return m_size;
+    }
+
+    explicit operator bool() const
+    {
+        return m_buffer != nullptr;
+    }
+};
+
+// Device-level sub-allocator for vertex, index and storage data. Requests are
+// rounded up to a power-of-two size class and carved out of PAGE_SIZE buffers
+// created with util::createBuffer; requests above MAX_BLOCK_SIZE get a
+// dedicated buffer. Freed blocks are handed to the FramePacer by EndFrame and
+// reused once the frame completes.
+class BufferPool : public std::enable_shared_from_this<BufferPool>
+{
+  public:
+    constexpr static uint64_t MIN_BLOCK_SIZE = 256;
+    constexpr static uint64_t MAX_BLOCK_SIZE = 1024 * 1024;
+    constexpr static uint64_t PAGE_SIZE = 4 * MAX_BLOCK_SIZE;
+    constexpr static wgpu::BufferUsage USAGE = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::Index |
+                                               wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+
+  private:
+    friend BufferAllocation;
+
+    // Size classes MIN_BLOCK_SIZE .. MAX_BLOCK_SIZE, then dedicated buffers
+    constexpr static uint32_t SIZE_CLASSES = 13;
+    constexpr static uint32_t DEDICATED = SIZE_CLASSES;
+    static_assert(MIN_BLOCK_SIZE << (SIZE_CLASSES - 1) == MAX_BLOCK_SIZE);
+
+    struct Block
+    {
+        uint32_t page;
+        uint64_t offset;
+    };
+
+    struct Retired
+    {
+        Block block;
+        uint32_t sizeClass;
+        // Keeps a dedicated buffer alive until its frame completes
+        wgpu::Buffer buffer;
+    };
+
+    wgpu::Device m_device;
+    std::vector<wgpu::Buffer> m_pages;
+    std::array<std::vector<Block>, SIZE_CLASSES> m_free_blocks{};
+    std::vector<Retired> m_retired;
+    BufferPoolStats m_stats{};
+    // Set by Release: frees return immediately, the device is idle
+    bool m_detached{false};
+
+    auto retire(const BufferAllocation &allocation) -> void;
+    auto reclaim(std::vector<Retired> &retired) -> void;
+
+  public:
+    explicit BufferPool(wgpu::Device device);
+
+    // One pool per device, created on first use
+    static auto Get(const wgpu::Device &device) -> BufferPool &;
+
+    // Drops the device's pool; call after the GPU is idle. Allocations still
+    // held keep their buffers alive.
+    static auto Release(const wgpu::Device &device) -> void;
+
+    auto Allocate(uint64_t size) -> BufferAllocation;
+
+    // Defers this frame's frees until the frame completes; call before
+    // FramePacer::EndFrame
+    auto EndFrame(FramePacer &pacer) -> void;
+
+    auto Stats() const -> BufferPoolStats;
+};
+} // namespace wglib
@@ -1,9 +1,16 @@
 #include "CoreEngine.hpp"
 #include "CoreUtil.hpp"
+#include "BufferPool.hpp"
+#include "PipelineCache.hpp"
+#include "TransformBuffer.hpp"
 #include "GLFW/glfw3.h"
 #include "lib/compute/ComputeEngine.hpp"
+#include "lib/render_layer/CircleMesh.hpp"
 
+#include <chrono>
 #include <memory>
+#include <thread>
+#include <vector>
 #ifndef __EMSCRIPTEN__
 #include <webgpu/webgpu_cpp_print.h>
 #endif
@@ -14,15 +21,23 @@
 #include "webgpu/webgpu_cpp.h"
 
 namespace wglib {
-Engine::Engine(glm::vec2 size, std::string_view title) : m_window_size(size) {
+namespace {
+// Simulated frame time used when headless without a target FPS
+constexpr auto HEADLESS_FRAME_TIME = 1.0 / 60.0;
+} // namespace
+
+Engine::Engine(glm::vec2 size, std::string_view title, EngineOptions options)
+    : m_options(options), m_window_size(size) {
 
   constexpr auto K_TIMED_WAIT_ANY = wgpu::InstanceFeatureName::TimedWaitAny;
   const wgpu::InstanceDescriptor instanceDesc{
       .requiredFeatureCount = 1, .requiredFeatures = &K_TIMED_WAIT_ANY};
   m_instance = wgpu::CreateInstance(&instanceDesc);
 
+  const wgpu::RequestAdapterOptions adapterOptions{
+      .forceFallbackAdapter = m_options.softwareAdapter};
   const auto f1 = m_instance.RequestAdapter(
-      nullptr, wgpu::CallbackMode::WaitAnyOnly,
+      &adapterOptions, wgpu::CallbackMode::WaitAnyOnly,
       [&](wgpu::RequestAdapterStatus status, wgpu::Adapter a,
           wgpu::StringView message) {
         if (status != wgpu::RequestAdapterStatus::Success) {
@@ -43,7 +58,14 @@ Engine::Engine(glm::vec2 size, std::string_view title) : m_window_size(size) {
   // queue.Submit(0, nullptr);
   // exit(1);
 
+  std::vector<wgpu::FeatureName> features;
+  if (m_options.timestampQuery &&
+      m_adapter.HasFeature(wgpu::FeatureName::TimestampQuery)) {
+    features.push_back(wgpu::FeatureName::TimestampQuery);
+  }
   wgpu::DeviceDescriptor desc{};
+  desc.requiredFeatureCount = features.size();
+  desc.requiredFeatures = features.data();
   desc.SetDeviceLostCallback(
       wgpu::CallbackMode::AllowSpontaneous,
       [](const wgpu::Device &, wgpu::DeviceLostReason reason,
@@ -74,20 +96,45 @@ Engine::Engine(glm::vec2 size, std::string_view title) : m_window_size(size) {
     exit(0);
   };
 
-  // Create Window
-  this->m_window_manager = std::make_unique<WindowManager>(
-      size.x, size.y, title, m_instance, m_device, m_adapter);
+  // Create Window, or the texture we render into when headless
+  wgpu::TextureFormat format;
+  if (m_options.headless) {
+    this->m_offscreen_target = std::make_unique<OffscreenTarget>(
+        static_cast<uint32_t>(size.x), static_cast<uint32_t>(size.y),
+        m_device);
+    format = m_offscreen_target->format();
+  } else {
+    this->m_window_manager = std::make_unique<WindowManager>(
+        size.x, size.y, title, m_instance, m_device, m_adapter,
+        m_options.surface);
+    format = m_window_manager->format();
+  }
+
+  this->m_frame_pacer = std::make_unique<FramePacer>(
+      m_instance, m_device, m_options.framesInFlight);
 
   // Pass to Renderer
 
   this->m_renderer = std::make_unique<Renderer>(
-      m_instance, m_adapter, m_device, m_window_manager->format(), size);
+      m_instance, m_adapter, m_device, format, size,
+      m_frame_pacer->FramesInFlight());
+
+  this->m_render_graph = std::make_unique<RenderGraph>(m_device);
 
   // create computeEngine
   this->m_computeEngine = std::make_unique<compute::ComputeEngine>(m_device);
+
+  if (m_options.collectFrameStats) {
+    this->m_frame_stats = std::make_unique<FrameStats>();
+  }
 }
 
 auto Engine::Start() -> void {
+  m_running = true;
+  if (m_options.headless) {
+    run_headless();
+    return;
+  }
 #if defined(__EMSCRIPTEN__)
   // For Emscripten, we need a lambda wrapper since render() is a member
   // function
@@ -102,42 +149,226 @@ auto Engine::Start() -> void {
       },
       this, 0, true);
 #else
-  while (!glfwWindowShouldClose(m_window_manager->window())) {
+  m_last_frame_time = glfwGetTime();
+  while (m_running && !glfwWindowShouldClose(m_window_manager->window())) {
     const auto currTime = glfwGetTime();
     const auto delta = currTime - m_last_frame_time;
     m_last_frame_time = currTime;
-    glfwPollEvents();
     update_frame(delta);
+
+    // Sleep in the event wait until the next tick or frame is due instead of
+    // spinning on the poll
+    if (const auto wait = m_scheduler.TimeUntilNextEvent(); wait > 0.0) {
+      glfwWaitEventsTimeout(wait);
+    } else {
+      glfwPollEvents();
+    }
   }
 #endif
 }
 
-auto Engine::update_frame(double delta) -> void {
-  m_accumulator += delta;
+auto Engine::run_headless() -> void {
+  using Clock = std::chrono::steady_clock;
 
-  if (m_target_frame_time > 0.0 && m_accumulator < m_target_frame_time) {
-    return;
+  // With the simulated clock there is no display to pace against, so frames
+  // run back to back and each advances time by exactly one target frame.
+  const auto simulatedDelta = m_scheduler.RenderInterval() > 0.0
+                                  ? m_scheduler.RenderInterval()
+                                  : HEADLESS_FRAME_TIME;
+  auto last = Clock::now();
+  uint32_t frame = 0;
+  while (m_running &&
+         (m_options.frameCount == 0 || frame < m_options.frameCount)) {
+    if (m_options.simulatedClock) {
+      update_frame(simulatedDelta);
+      ++frame;
+      continue;
+    }
+
+    const auto now = Clock::now();
+    const auto delta = std::chrono::duration<double>(now - last).count();
+    last = now;
+    if (update_frame(delta)) {
+      ++frame;
+    }
+    if (const auto wait = m_scheduler.TimeUntilNextEvent(); wait > 0.0) {
+      std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
   }
+  WaitIdle();
+}
 
-  m_accumulator = 0.0;
+auto Engine::Stop() -> void {
+  m_running = false;
+#ifdef __EMSCRIPTEN__
+  emscripten_cancel_main_loop();
+#endif
+}
 
-  m_computeEngine->Compute();
+auto Engine::WaitIdle() -> void {
+  const auto future = m_device.GetQueue().OnSubmittedWorkDone(
+      wgpu::CallbackMode::WaitAnyOnly,
+      [](wgpu::QueueWorkDoneStatus status, wgpu::StringView message) {
+        if (status != wgpu::QueueWorkDoneStatus::Success) {
+          util::log("Failed waiting for queue: {}", message.data);
+        }
+      });
+  m_instance.WaitAny(future, UINT64_MAX);
+  // Deliver callbacks, e.g. compute results, that completed with this work
+  m_instance.ProcessEvents();
+}
+
+auto Engine::ReadFrame() -> std::vector<uint8_t> {
+  if (not m_offscreen_target) {
+    util::log("ReadFrame is only available in headless mode");
+    return {};
+  }
+  return m_offscreen_target->readback(m_instance, m_device);
+}
+
+auto Engine::update_frame(double delta) -> bool {
+  const auto schedule = m_scheduler.Advance(delta);
+
+  if (m_frame_stats && schedule.render) {
+    m_frame_stats->BeginFrame();
+  }
+
+  for (uint32_t tick = 0; tick < schedule.ticks; ++tick) {
+    if (m_fixed_update_function) {
+      m_fixed_update_function(m_scheduler.TickInterval());
+    }
+    m_computeEngine->Compute(*m_render_graph);
+    submit_graph();
+  }
+
+  if (!schedule.render) {
+    // Still deliver results of work dispatched by the ticks
+    m_instance.ProcessEvents();
+    return false;
+  }
+
+  m_time += schedule.renderDelta;
+
+  // Blocks only when the GPU is a full ring of frames behind
+  m_frame_pacer->BeginFrame();
+
+  // Without a fixed tick, compute work keeps running once per rendered frame,
+  // recorded ahead of the passes that draw it
+  if (!m_scheduler.HasFixedTick()) {
+    m_computeEngine->Compute(*m_render_graph);
+  }
   m_instance.ProcessEvents();
   render();
   if (m_update_function) {
-    m_update_function(delta);
+    m_update_function(schedule.renderDelta, schedule.alpha);
+  }
+
+  BufferPool::Get(m_device).EndFrame(*m_frame_pacer);
+  m_frame_pacer->EndFrame();
+  PipelineCache::Get(m_device).EndFrame();
+  m_render_graph->EndFrame();
+
+  if (m_frame_stats) {
+    m_frame_stats->EndFrame(m_device.GetQueue());
   }
+  return true;
 }
 
 auto Engine::render() -> void {
-  wgpu::SurfaceTexture surfaceTexture;
-  m_window_manager->surface().GetCurrentTexture(&surfaceTexture);
-  m_renderer->Render(surfaceTexture);
+  wgpu::Texture texture;
+  wgpu::TextureView view;
+  if (m_offscreen_target) {
+    texture = m_offscreen_target->texture();
+    view = m_offscreen_target->view();
+  } else {
+    if (not m_window_manager->applyResize()) {
+      // Minimized: compute still runs, nothing is drawn
+      skip_frame();
+      return;
+    }
+    const glm::vec2 windowSize{m_window_manager->width(),
+                               m_window_manager->height()};
+    if (windowSize != m_window_size) {
+      m_window_size = windowSize;
+      m_renderer->SetUniforms({.screen_size = m_window_size});
+    }
+
+    wgpu::SurfaceTexture surfaceTexture;
+    m_window_manager->surface().GetCurrentTexture(&surfaceTexture);
+    switch (surfaceTexture.status) {
+    case wgpu::SurfaceGetCurrentTextureStatus::SuccessOptimal:
+      break;
+    case wgpu::SurfaceGetCurrentTextureStatus::SuccessSuboptimal:
+      // Still presentable; reconfigure for the next frame if it was resized
+      m_window_manager->markSuboptimal();
+      break;
+    case wgpu::SurfaceGetCurrentTextureStatus::Timeout:
+    case wgpu::SurfaceGetCurrentTextureStatus::Outdated:
+    case wgpu::SurfaceGetCurrentTextureStatus::Lost:
+      m_window_manager->markOutdated();
+      skip_frame();
+      return;
+    default:
+      util::log("Failed to acquire the surface texture");
+      skip_frame();
+      return;
+    }
+    texture = surfaceTexture.texture;
+    // Reuses the view whenever the surface hands back a texture it returned
+    // before; stale entries are evicted by PipelineCache::EndFrame
+    view = PipelineCache::Get(m_device).GetTextureView(texture);
+  }
+
+  auto &graph = *m_render_graph;
+  const auto backbuffer = graph.ImportTexture("Backbuffer", texture, view);
+  const auto frameIndex = m_frame_pacer->FrameIndex();
+  if (m_render_graph_function) {
+    const TransientTextureDesc sceneDesc{.width = texture.GetWidth(),
+                                         .height = texture.GetHeight(),
+                                         .format = m_renderer->GetFormat()};
+    const auto scene = m_renderer->AddPass(graph, sceneDesc, frameIndex,
+                                           m_scene.DrawList());
+    m_render_graph_function(graph, scene, backbuffer);
+  } else {
+    m_renderer->AddPass(graph, backbuffer, frameIndex, m_scene.DrawList());
+  }
+  submit_graph();
+  m_renderer->EndFrame();
+
 #ifndef __EMSCRIPTEN__
   // Emscripten handles presentation automatically via requestAnimationFrame
-  m_window_manager->surface().Present();
+  if (m_window_manager) {
+    m_window_manager->surface().Present();
+  }
 #endif
 }
 
-Engine::~Engine() {}
+auto Engine::skip_frame() -> void {
+  // Compute added this frame is submitted without the scene; layers pushed
+  // for it are dropped like after a drawn frame
+  submit_graph();
+  m_renderer->EndFrame();
+}
+
+auto Engine::submit_graph() -> void {
+  if (m_render_graph->Empty()) {
+    return;
+  }
+  auto encoder = m_device.CreateCommandEncoder();
+  m_render_graph->Execute(encoder);
+  const auto commandBuffer = encoder.Finish();
+  m_device.GetQueue().Submit(1, &commandBuffer);
+  m_computeEngine->Submitted();
+}
+
+Engine::~Engine() {
+  // Returns blocks freed by the last frames before the pool goes away
+  if (m_frame_pacer) {
+    m_frame_pacer->WaitIdle();
+  }
+  TransformBuffer::Release(m_device);
+  render_layers::CircleMesh::Release(m_device);
+  BufferPool::Release(m_device);
+  PipelineCache::Release(m_device);
+}
 } // namespace wglib
@@ -1,62 +1,218 @@
 #pragma once
+#include "BufferPool.hpp"
+#include "FramePacer.hpp"
+#include "FrameScheduler.hpp"
+#include "FrameStats.hpp"
 #include "GLFW/glfw3.h"
+#include "OffscreenTarget.hpp"
+#include "PipelineCache.hpp"
+#include "RenderGraph.hpp"
+#include "Scene.hpp"
 #include "WindowManager.hpp"
+#include "compute/ComputeAwaitable.hpp"
 #include "compute/ComputeEngine.hpp"
+#include "compute/ComputeGraph.hpp"
 #include "lib/compute/ComputeLayer.hpp"
 #include "lib/render_layer/RenderLayer.hpp"
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
 #include <utility>
+#include <vector>
 #include <webgpu/webgpu_cpp.h>
 
 #include "CoreRenderer.hpp"
 
 namespace wglib
 {
+struct EngineOptions
+{
+    // Render into an owned offscreen texture instead of a window surface
+    bool headless{false};
+    // Request Dawn's fallback CPU adapter (SwiftShader) instead of a GPU
+    bool softwareAdapter{false};
+    // Frames run by Start() in headless mode, 0 runs until Stop()
+    uint32_t frameCount{0};
+    // Headless only: advance time by one frame per iteration so frames run as
+    // fast as possible. When false the wall clock is used and idle time slept.
+    bool simulatedClock{true};
+    // Record CPU and GPU completion time of every frame, see GetFrameStats()
+    bool collectFrameStats{false};
+    // Frames the CPU may record ahead of the GPU, clamped to [1, 3]
+    uint32_t framesInFlight{2};
+    // Request the TimestampQuery feature when the adapter has it, so layers
+    // can time their passes; check with wgpu::Device::HasFeature
+    bool timestampQuery{false};
+    // Present mode and format of the window surface, see SurfaceOptions
+    SurfaceOptions surface{};
+};
+
 class Engine
 {
+    EngineOptions m_options;
     std::unique_ptr<WindowManager> m_window_manager;
+    std::unique_ptr<OffscreenTarget> m_offscreen_target;
     std::unique_ptr<wglib::compute::ComputeEngine> m_computeEngine;
     wgpu::Instance m_instance;
     wgpu::Device m_device;
     wgpu::Adapter m_adapter;
     glm::vec2 m_window_size;
     std::unique_ptr<Renderer> m_renderer;
-    std::function<void(double)> m_update_function;
+    // Rebuilt for every submission: the compute of a tick, or a whole frame
+    std::unique_ptr<RenderGraph> m_render_graph;
+    std::function<void(RenderGraph &, RenderGraphTexture, RenderGraphTexture)> m_render_graph_function;
+    Scene m_scene;
+    std::unique_ptr<FramePacer> m_frame_pacer;
+    std::unique_ptr<FrameStats> m_frame_stats;
+    std::function<void(double, double)> m_update_function;
+    std::function<void(double)> m_fixed_update_function;
+    FrameScheduler m_scheduler;
     double m_last_frame_time{0.0f};
-    double m_target_frame_time{0.0};
-    double m_accumulator{0.0};
+    double m_time{0.0};
+    bool m_running{false};
 
     auto render() -> void;
-    auto update_frame(double delta) -> void;
+    // When no surface texture can be drawn to this frame
+    auto skip_frame() -> void;
+    // Records the graph into one command buffer and submits it
+    auto submit_graph() -> void;
+    // Returns whether a frame was rendered
+    auto update_frame(double delta) -> bool;
+    auto run_headless() -> void;
 
   public:
-    Engine(glm::vec2 size, std::string_view title);
+    Engine(glm::vec2 size, std::string_view title, EngineOptions options = {});
 
     ~Engine();
 
     auto GetWindow() -> GLFWwindow *
     {
-        return m_window_manager->window();
+        return m_window_manager ? m_window_manager->window() : nullptr;
+    }
+
+    auto IsHeadless() const -> bool
+    {
+        return m_options.headless;
     }
 
     auto Start() -> void;
 
-    auto OnUpdate(std::function<void(float)> &&function) -> void
+    // Ends the main loop after the current frame
+    auto Stop() -> void;
+
+    // Blocks until all work submitted to the queue has finished
+    auto WaitIdle() -> void;
+
+    // Reads back the last rendered frame as tightly packed RGBA8 rows.
+    // Only available in headless mode.
+    auto ReadFrame() -> std::vector<uint8_t>;
+
+    // nullptr unless EngineOptions::collectFrameStats is set
+    auto GetFrameStats() const -> const FrameStats *
+    {
+        return m_frame_stats.get();
+    }
+
+    // Draw counters of the last rendered frame
+    auto GetRenderStats() const -> const RenderStats &
     {
-        m_update_function = function;
+        return m_renderer->GetStats();
     }
 
+    // Pass and transient texture counters of the last submitted graph
+    auto GetRenderGraphStats() const -> const RenderGraphStats &
+    {
+        return m_render_graph->Stats();
+    }
+
+    // Pipelines, bind groups and views shared by every layer of this engine
+    auto GetPipelineCache() -> PipelineCache &
+    {
+        return PipelineCache::Get(m_device);
+    }
+
+    // Vertex, index and storage blocks shared by every layer of this engine
+    auto GetBufferPool() -> BufferPool &
+    {
+        return BufferPool::Get(m_device);
+    }
+
+    // Batching of Rectangle/Circle/Triangle layers is on by default
+    auto SetBatchingEnabled(bool enabled) -> void
+    {
+        m_renderer->SetBatchingEnabled(enabled);
+    }
+
+    // Seconds of frame time passed to OnUpdate so far. Simulated when headless.
+    auto GetTime() const -> double
+    {
+        return m_time;
+    }
+
+    // Called once per rendered frame with the time since the last one
+    template <typename F>
+        requires(std::invocable<F &, float> and not std::invocable<F &, float, float>)
+    auto OnUpdate(F &&function) -> void
+    {
+        m_update_function = [function = std::forward<F>(function)](double delta, double) mutable {
+            function(delta);
+        };
+    }
+
+    // Called once per rendered frame with the time since the last one and the
+    // interpolation alpha between the last two fixed ticks
+    template <typename F>
+        requires std::invocable<F &, float, float>
+    auto OnUpdate(F &&function) -> void
+    {
+        m_update_function = std::forward<F>(function);
+    }
+
+    // Called once per fixed simulation tick with the tick length, see SetTickRate.
+    // Compute layers pushed here are dispatched with the tick.
+    auto OnFixedUpdate(std::function<void(double)> &&function) -> void
+    {
+        m_fixed_update_function = std::move(function);
+    }
+
+    // Called every rendered frame with its RenderGraph, after the pass drawing
+    // the layers. Once set, the layers draw into scene, a transient texture of
+    // the target's size and format, and the passes added here must write
+    // backbuffer from it, e.g. a chain of post-processing effects.
+    auto OnRenderGraph(std::function<void(RenderGraph &graph, RenderGraphTexture scene, RenderGraphTexture backbuffer)>
+                           &&function) -> void
+    {
+        m_render_graph_function = std::move(function);
+    }
+
+    // Render rate, 0 renders as often as the loop runs
     auto SetTargetFPS(double fps) -> void
     {
-        m_target_frame_time = fps > 0.0 ? 1.0 / fps : 0.0;
+        m_scheduler.SetRenderRate(fps);
+    }
+
+    // Fixed simulation rate independent of the render rate. With a tick rate
+    // set, compute work is dispatched per tick instead of per rendered frame.
+    auto SetTickRate(double hz) -> void
+    {
+        m_scheduler.SetTickRate(hz);
+    }
+    // Layers added here are drawn every frame, before the layers passed to Draw
+    auto GetScene() -> Scene &
+    {
+        return m_scene;
     }
-    template <std::derived_from<render_layers::RenderLayer> T> auto Draw(Renderer::Ref<T> renderLayer) -> void
+
+    // Draws the layer this frame only; prefer GetScene() for layers that stay.
+    // Lower orders draw first; layers of equal order may be reordered to share
+    // GPU state, so give overlapping layers distinct orders.
+    template <std::derived_from<render_layers::RenderLayer> T>
+    auto Draw(Renderer::Ref<T> renderLayer, int32_t order = 0) -> void
     {
-        m_renderer->pushRenderLayer(renderLayer);
+        m_renderer->pushRenderLayer(renderLayer, order);
     }
 
     template <std::derived_from<compute::IComputeLayer> LayerType, typename... Args>
@@ -64,11 +220,30 @@ class Engine
     {
         return m_computeEngine->InitComputeLayer<LayerType>(std::forward<Args>(args)...);
     }
+    // With iterations > 1 the steps are recorded back to back into one
+    // submission and onComplete gets the result of the last
     template <typename TResult, std::invocable<TResult> CB>
-    auto PushComputeLayer(compute::ComputeEngine::ComputeLayerHandle<TResult> &handle, CB &&onComplete) -> void
+    auto PushComputeLayer(compute::ComputeEngine::ComputeLayerHandle<TResult> &handle, CB &&onComplete,
+                          uint32_t iterations = 1) -> void
     {
 
-        m_computeEngine->PushComputeLayer(handle, std::forward<CB>(onComplete));
+        m_computeEngine->PushComputeLayer(handle, std::forward<CB>(onComplete), iterations);
+    }
+    // Pushes the layer like PushComputeLayer; co_await the result from a
+    // compute::Workflow coroutine. Create several awaitables before awaiting
+    // the first to run their layers in one submission.
+    template <typename TResult>
+    auto Compute(compute::ComputeEngine::ComputeLayerHandle<TResult> &handle, uint32_t iterations = 1)
+        -> compute::ComputeAwaitable<TResult>
+    {
+        compute::ComputeAwaitable<TResult> awaitable;
+        m_computeEngine->PushComputeLayer(handle, awaitable.Completion(), iterations);
+        return awaitable;
+    }
+    // Queues every layer of the graph for the current frame, see ComputeGraph
+    auto PushComputeGraph(compute::ComputeGraph &graph) -> void
+    {
+        m_computeEngine->PushComputeGraph(graph);
     }
     template <std::derived_from<render_layers::RenderLayer> T, typename... Args> auto CreateRenderLayer(Args &&...args)
     {
@@ -4,6 +4,8 @@
 
 #include "CoreRenderer.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <ranges>
 
 #include "CoreUtil.hpp"
@@ -12,87 +14,302 @@
 namespace wglib
 {
 Renderer::Renderer(const wgpu::Instance &instance, wgpu::Adapter &adapter, wgpu::Device &device,
-                   wgpu::TextureFormat format, glm::vec2 screenSize)
-    : m_instance(instance), m_adapter(adapter), m_device(device), m_format(format), m_uniforms(screenSize)
+                   wgpu::TextureFormat format, glm::vec2 screenSize, uint32_t framesInFlight)
+    : m_instance(instance), m_adapter(adapter), m_device(device), m_format(format),
+      m_frames_in_flight(framesInFlight), m_uniforms(screenSize), m_upload_belt(instance, device)
 {
     CreateBindGroupLayout();
-    CreateAndInitUniformBuffer();
+    CreateAndInitUniformBuffers();
+    m_batcher = std::make_unique<DrawBatcher>(m_device, m_format, m_bind_group_layout);
 }
 
 auto Renderer::CreateBindGroupLayout() -> void
 {
-    wgpu::BindGroupLayoutEntry entry{
-        .binding = 0,
-        .visibility = wgpu::ShaderStage::Vertex,
-        .buffer = {.type = wgpu::BufferBindingType::Uniform, .minBindingSize = sizeof(Uniforms)}};
+    const wgpu::BindGroupLayoutEntry entries[2]{
+        {.binding = 0,
+         .visibility = wgpu::ShaderStage::Vertex,
+         .buffer = {.type = wgpu::BufferBindingType::Uniform, .minBindingSize = sizeof(Uniforms)}},
+        // Per-object transforms, see TransformBuffer
+        {.binding = 1,
+         .visibility = wgpu::ShaderStage::Vertex,
+         .buffer = {.type = wgpu::BufferBindingType::ReadOnlyStorage, .minBindingSize = sizeof(ObjectTransform)}},
+    };
 
-    wgpu::BindGroupLayoutDescriptor layoutDesc{.entryCount = 1, .entries = &entry};
+    wgpu::BindGroupLayoutDescriptor layoutDesc{.entryCount = std::size(entries), .entries = entries};
 
     m_bind_group_layout = m_device.CreateBindGroupLayout(&layoutDesc);
 }
 
-auto Renderer::CreateAndInitUniformBuffer() -> void
+auto Renderer::CreateAndInitUniformBuffers() -> void
 {
-    m_uniform_buffer =
-        util::createBuffer<Uniforms, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform>(m_device, 1, true);
-    m_uniform_buffer.WriteMappedRange(0, &m_uniforms, sizeof(Uniforms));
-    m_uniform_buffer.Unmap();
+    for (uint32_t slot = 0; slot < m_frames_in_flight; ++slot)
+    {
+        auto &buffer = m_uniform_buffers[slot];
+        buffer =
+            util::createBuffer<Uniforms, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform>(m_device, 1, true);
+        buffer.WriteMappedRange(0, &m_uniforms, sizeof(Uniforms));
+        buffer.Unmap();
+    }
+    CreateBindGroups();
 }
 
-auto Renderer::UpdateUniformBuffer() -> void
+auto Renderer::CreateBindGroups() -> void
 {
-    // TODO
-    //  instead need to just write to the uniform buffer
+    const auto &transforms = TransformBuffer::Get(m_device).Binding();
+    for (uint32_t slot = 0; slot < m_frames_in_flight; ++slot)
+    {
+        const wgpu::BindGroupEntry entries[2]{
+            {.binding = 0, .buffer = m_uniform_buffers[slot], .offset = 0, .size = sizeof(Uniforms)},
+            {.binding = 1, .buffer = transforms.Buffer(), .offset = transforms.Offset(), .size = transforms.Size()},
+        };
+        wgpu::BindGroupDescriptor desc{
+            .layout = m_bind_group_layout,
+            .entryCount = std::size(entries),
+            .entries = entries,
+        };
+        m_bind_groups[slot] = m_device.CreateBindGroup(&desc);
+    }
+}
 
-    wgpu::BufferDescriptor bufferDesc{.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform,
-                                      .size = sizeof(Uniforms),
-                                      .mappedAtCreation = true};
-    if (m_uniforms_dirty)
+auto Renderer::UpdateUniformBuffer(uint32_t frameIndex) -> void
+{
+    const auto slotBit = 1u << frameIndex;
+    if (m_uniforms_dirty_slots & slotBit)
     {
-        m_device.GetQueue().WriteBuffer(m_uniform_buffer, 0, reinterpret_cast<uint8_t *>(&m_uniforms),
-                                        sizeof(Uniforms));
-        m_uniforms_dirty = false;
+        m_upload_belt.Write(m_uniform_buffers[frameIndex], 0, &m_uniforms, sizeof(Uniforms));
+        m_uniforms_dirty_slots &= ~slotBit;
     }
 }
 
-auto Renderer::Render(wgpu::SurfaceTexture &surfaceTexture) -> void
+auto Renderer::RecordBundle(StaticGroup &group, uint32_t frameIndex) -> void
 {
-    for (auto &layer : m_render_layers)
+    const wgpu::RenderBundleEncoderDescriptor desc{.colorFormatCount = 1, .colorFormats = &m_format};
+    auto bundleEncoder = m_device.CreateRenderBundleEncoder(&desc);
+    render_layers::RenderEncoder encoder(bundleEncoder);
+
+    // Bundles start without any state, so the bundle binds its slot's uniforms
+    encoder.SetBindGroup(0, m_bind_groups[frameIndex]);
+    for (const auto &[layer, revision] : group.layers)
     {
-        layer->UpdateRes(m_device);
+        layer->Render(encoder);
     }
+    group.bundles[frameIndex] = bundleEncoder.Finish();
+    ++m_stats.bundlesRecorded;
+    m_stats.stateChanges += encoder.IssuedStateChanges();
+    m_stats.stateChangesSkipped += encoder.SkippedStateChanges();
+}
 
-    wgpu::BindGroupEntry entry{.binding = 0, .buffer = m_uniform_buffer, .offset = 0, .size = sizeof(Uniforms)};
-    wgpu::BindGroupDescriptor desc{
-        .layout = m_bind_group_layout,
-        .entryCount = 1,
-        .entries = &entry,
-    };
-    auto m_bind_group = m_device.CreateBindGroup(&desc);
+auto Renderer::CloseStaticGroup() -> void
+{
+    if (m_draw_items.empty() or m_draw_items.back().kind != DrawItem::Kind::Bundle)
+    {
+        return;
+    }
+    // The run ended before the recorded one did
+    auto &group = m_static_groups[m_group_count - 1];
+    if (group.layers.size() > m_group_cursor)
+    {
+        group.layers.resize(m_group_cursor);
+        group.bundles = {};
+    }
+}
+
+auto Renderer::Submit(const render_layers::RenderLayer *layer, render_layers::RenderContext &context,
+                      RenderGraph::PassBuilder &builder) -> void
+{
+    // Passes writing the textures this frame run before the scene pass
+    for (const auto &texture : layer->GetSampledTextures())
+    {
+        builder.Read(builder.Import("Sampled", texture));
+    }
+    if (layer->IsStatic())
+    {
+        // Still runs every frame: it may replace a buffer, which bumps the revision
+        layer->UpdateRes(context);
+        if (m_draw_items.empty() or m_draw_items.back().kind != DrawItem::Kind::Bundle)
+        {
+            if (m_static_groups.size() == m_group_count)
+            {
+                m_static_groups.emplace_back();
+            }
+            m_draw_items.push_back({.kind = DrawItem::Kind::Bundle, .group = m_group_count++});
+            m_group_cursor = 0;
+        }
+
+        auto &group = m_static_groups[m_group_count - 1];
+        const auto revision = layer->Revision();
+        if (m_group_cursor >= group.layers.size() or group.layers[m_group_cursor].first != layer or
+            group.layers[m_group_cursor].second != revision)
+        {
+            group.layers.resize(m_group_cursor);
+            group.layers.emplace_back(layer, revision);
+            group.bundles = {};
+        }
+        ++m_group_cursor;
+        ++m_stats.staticLayers;
+        return;
+    }
+    CloseStaticGroup();
+
+    const auto geometry = m_batching_enabled ? layer->GetBatchGeometry() : std::nullopt;
+    if (not geometry)
+    {
+        layer->UpdateRes(context);
+        m_draw_items.push_back({.kind = DrawItem::Kind::Layer, .layer = layer});
+        return;
+    }
+
+    const auto run = m_batcher->Append(*geometry);
+    ++m_stats.batchedLayers;
+    if (not m_draw_items.empty() and m_draw_items.back().kind == DrawItem::Kind::Batch)
+    {
+        // Runs are appended back to back, so extending the last one is enough
+        m_draw_items.back().run.indexCount += run.indexCount;
+    }
+    else
+    {
+        m_draw_items.push_back({.kind = DrawItem::Kind::Batch, .run = run});
+    }
+}
+
+auto Renderer::AddPass(RenderGraph &graph, RenderGraphTexture target, uint32_t frameIndex,
+                       std::span<const RenderQueueEntry> retained) -> RenderGraphTexture
+{
+    return AddScenePass(
+        graph, [&](RenderGraph::PassBuilder &builder) { return builder.Write(target); }, frameIndex, retained);
+}
 
+auto Renderer::AddPass(RenderGraph &graph, const TransientTextureDesc &desc, uint32_t frameIndex,
+                       std::span<const RenderQueueEntry> retained) -> RenderGraphTexture
+{
+    return AddScenePass(
+        graph, [&](RenderGraph::PassBuilder &builder) { return builder.Create("Scene", desc); }, frameIndex,
+        retained);
+}
+
+auto Renderer::AddScenePass(RenderGraph &graph,
+                            const std::function<RenderGraphTexture(RenderGraph::PassBuilder &)> &output,
+                            uint32_t frameIndex, std::span<const RenderQueueEntry> retained) -> RenderGraphTexture
+{
+    RenderGraphTexture target;
+    graph.AddPass("Scene", [&](RenderGraph::PassBuilder &builder) {
+        // Keeps the frame's uploads even if nothing reads the target
+        builder.SideEffect();
+        Prepare(builder, frameIndex, retained);
+        target = output(builder);
+        return [this, target, frameIndex](const RenderGraph::Resources &resources, wgpu::CommandEncoder &encoder) {
+            Record(encoder, resources.View(target), frameIndex);
+        };
+    });
+    return target;
+}
+
+auto Renderer::Prepare(RenderGraph::PassBuilder &builder, uint32_t frameIndex,
+                       std::span<const RenderQueueEntry> retained) -> void
+{
+    m_stats = {};
+    m_draw_items.clear();
+    m_batcher->Clear();
+    m_group_count = 0;
+    m_group_cursor = 0;
+    m_upload_belt.Begin(frameIndex);
+    render_layers::RenderContext context{.device = m_device, .uploads = m_upload_belt, .frameIndex = frameIndex};
+
+    m_immediate_queue.clear();
+    for (const auto &[layer, order] : m_render_layers)
+    {
+        m_immediate_queue.push_back({render_layers::MakeSortKey(order, layer->GetDrawState()), layer.get()});
+    }
+    std::ranges::stable_sort(m_immediate_queue, {}, &RenderQueueEntry::key);
+
+    // Both queues are sorted, merge them without building a combined list
+    auto retainedIt = retained.begin();
+    auto immediateIt = m_immediate_queue.cbegin();
+    while (retainedIt != retained.end() or immediateIt != m_immediate_queue.cend())
+    {
+        if (immediateIt == m_immediate_queue.cend() or
+            (retainedIt != retained.end() and retainedIt->key <= immediateIt->key))
+        {
+            Submit((retainedIt++)->layer, context, builder);
+        }
+        else
+        {
+            Submit((immediateIt++)->layer, context, builder);
+        }
+    }
+    CloseStaticGroup();
+    m_static_groups.resize(m_group_count);
+    m_batcher->Upload(frameIndex, m_upload_belt);
+    UpdateUniformBuffer(frameIndex);
+    if (TransformBuffer::Get(m_device).Upload(m_upload_belt))
+    {
+        // The transforms moved to a larger buffer; bundles bind the old groups
+        CreateBindGroups();
+        for (auto &group : m_static_groups)
+        {
+            group.bundles = {};
+        }
+    }
+}
+
+auto Renderer::Record(wgpu::CommandEncoder &commandEncoder, const wgpu::TextureView &target, uint32_t frameIndex)
+    -> void
+{
     wgpu::RenderPassColorAttachment attachment{
-        .view = surfaceTexture.texture.CreateView(), .loadOp = wgpu::LoadOp::Clear, .storeOp = wgpu::StoreOp::Store};
+        .view = target, .loadOp = wgpu::LoadOp::Clear, .storeOp = wgpu::StoreOp::Store};
 
     wgpu::RenderPassDescriptor renderPassDesc{.colorAttachmentCount = 1, .colorAttachments = &attachment};
 
-    auto encoder = m_device.CreateCommandEncoder();
-    auto renderPass = encoder.BeginRenderPass(&renderPassDesc);
+    // Every upload of the frame lands before the pass reads it
+    m_upload_belt.Flush(commandEncoder);
+    m_stats.bytesUploaded = m_upload_belt.Stats().bytes;
+    m_stats.uploadCopies = m_upload_belt.Stats().copies;
 
-    renderPass.SetBindGroup(0, m_bind_group, 0, 0);
+    auto renderPass = commandEncoder.BeginRenderPass(&renderPassDesc);
+    render_layers::RenderEncoder encoder(renderPass);
 
-    for (auto &layer : m_render_layers)
+    encoder.SetBindGroup(0, m_bind_groups[frameIndex]);
+
+    for (const auto &item : m_draw_items)
     {
-        layer->Render(renderPass);
+        switch (item.kind)
+        {
+        case DrawItem::Kind::Layer:
+            // Layers with their own group 0 (textures) may precede this one
+            encoder.SetBindGroup(0, m_bind_groups[frameIndex]);
+            item.layer->Render(encoder);
+            ++m_stats.drawCalls;
+            break;
+        case DrawItem::Kind::Batch:
+            // A preceding layer may have replaced group 0 with its own
+            encoder.SetBindGroup(0, m_bind_groups[frameIndex]);
+            m_batcher->Draw(encoder, frameIndex, item.run);
+            ++m_stats.drawCalls;
+            break;
+        case DrawItem::Kind::Bundle: {
+            auto &group = m_static_groups[item.group];
+            if (not group.bundles[frameIndex])
+            {
+                RecordBundle(group, frameIndex);
+            }
+            renderPass.ExecuteBundles(1, &group.bundles[frameIndex]);
+            // Executing a bundle clears the pass state
+            encoder.ResetState();
+            encoder.SetBindGroup(0, m_bind_groups[frameIndex]);
+            ++m_stats.bundlesExecuted;
+            break;
+        }
+        }
     }
 
     renderPass.End();
+    m_stats.stateChanges += encoder.IssuedStateChanges();
+    m_stats.stateChangesSkipped += encoder.SkippedStateChanges();
+}
 
-    // update uniforms at the end
-    UpdateUniformBuffer();
-
-    const auto encoderFinish = encoder.Finish();
-    m_device.GetQueue().Submit(1, &encoderFinish);
-
+auto Renderer::EndFrame() -> void
+{
+    m_upload_belt.EndFrame();
     m_render_layers.clear();
 }
 
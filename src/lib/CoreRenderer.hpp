@@ -1,20 +1,54 @@
 #pragma once
+#include <array>
 #include <concepts>
 #include <functional>
 #include <memory>
+#include <span>
 #include <webgpu/webgpu_cpp.h>
 
+#include "DrawBatcher.hpp"
+#include "FramePacer.hpp"
+#include "RenderGraph.hpp"
+#include "TransformBuffer.hpp"
+#include "UploadBelt.hpp"
 #include "glm/ext/vector_float2.hpp"
 #include "render_layer/RenderLayer.hpp"
 
 namespace wglib
 {
+class Scene;
 
 struct alignas(16) Uniforms
 {
     glm::vec2 screen_size;
 };
 
+struct RenderStats
+{
+    uint32_t drawCalls{0};
+    // Layers merged into batched draws
+    uint32_t batchedLayers{0};
+    // Static layers replayed from render bundles
+    uint32_t staticLayers{0};
+    uint32_t bundlesExecuted{0};
+    // Bundles re-recorded because a static layer changed
+    uint32_t bundlesRecorded{0};
+    // Pipeline, bind group and buffer bindings sent to the GPU, and those
+    // dropped because the same state was already bound
+    uint32_t stateChanges{0};
+    uint32_t stateChangesSkipped{0};
+    // Bytes staged through the upload belt and the copies recording them
+    uint64_t bytesUploaded{0};
+    uint32_t uploadCopies{0};
+};
+
+// A layer in the render queue, see render_layers::MakeSortKey
+struct RenderQueueEntry
+{
+    uint64_t key;
+    const render_layers::RenderLayer *layer;
+};
+
 template <typename T>
 concept RenderableLayer = std::derived_from<T, render_layers::RenderLayer>;
 
@@ -45,6 +79,7 @@ class Renderer
 
       private:
         friend Renderer;
+        friend Scene;
 
         const auto getLayer() const
         {
@@ -62,28 +97,113 @@ class Renderer
     const wgpu::Device &m_device;
     const wgpu::TextureFormat m_format;
 
-    std::vector<std::shared_ptr<const render_layers::RenderLayer>> m_render_layers{};
+    struct PushedLayer
+    {
+        std::shared_ptr<const render_layers::RenderLayer> layer;
+        int32_t order;
+    };
+    std::vector<PushedLayer> m_render_layers{};
+    // This frame's pushed layers, sorted by key
+    std::vector<RenderQueueEntry> m_immediate_queue{};
 
+    // One uniform buffer and bind group per frame in flight
+    uint32_t m_frames_in_flight;
     Uniforms m_uniforms;
-    bool m_uniforms_dirty;
-    wgpu::Buffer m_uniform_buffer;
+    uint32_t m_uniforms_dirty_slots{0};
+    std::array<wgpu::Buffer, FramePacer::MAX_FRAMES_IN_FLIGHT> m_uniform_buffers;
+    std::array<wgpu::BindGroup, FramePacer::MAX_FRAMES_IN_FLIGHT> m_bind_groups;
     wgpu::BindGroupLayout m_bind_group_layout;
 
-    auto UpdateUniformBuffer() -> void;
+    struct DrawItem
+    {
+        enum class Kind : uint8_t
+        {
+            Layer,
+            Batch,
+            Bundle,
+        };
+        Kind kind;
+        const render_layers::RenderLayer *layer{nullptr};
+        DrawBatcher::Run run{};
+        // Index into m_static_groups
+        uint32_t group{0};
+    };
+
+    // Consecutive static layers, recorded once per frame slot. Each layer is
+    // stored with the revision it had when the bundles were recorded; only
+    // layers submitted this frame are dereferenced.
+    struct StaticGroup
+    {
+        std::vector<std::pair<const render_layers::RenderLayer *, uint64_t>> layers;
+        std::array<wgpu::RenderBundle, FramePacer::MAX_FRAMES_IN_FLIGHT> bundles{};
+    };
+
+    UploadBelt m_upload_belt;
+    std::unique_ptr<DrawBatcher> m_batcher;
+    std::vector<DrawItem> m_draw_items;
+    std::vector<StaticGroup> m_static_groups;
+    bool m_batching_enabled{true};
+    RenderStats m_stats{};
+
+    auto UpdateUniformBuffer(uint32_t frameIndex) -> void;
+
+    auto CreateAndInitUniformBuffers() -> void;
 
-    auto CreateAndInitUniformBuffer() -> void;
+    // Binds each slot's uniforms and the current TransformBuffer
+    auto CreateBindGroups() -> void;
 
     auto CreateBindGroupLayout() -> void;
 
+    auto RecordBundle(StaticGroup &group, uint32_t frameIndex) -> void;
+
+    auto Submit(const render_layers::RenderLayer *layer, render_layers::RenderContext &context,
+                RenderGraph::PassBuilder &builder) -> void;
+    auto CloseStaticGroup() -> void;
+
+    // output declares the texture the pass draws into
+    auto AddScenePass(RenderGraph &graph, const std::function<RenderGraphTexture(RenderGraph::PassBuilder &)> &output,
+                      uint32_t frameIndex, std::span<const RenderQueueEntry> retained) -> RenderGraphTexture;
+
+    // Builds the draw list and stages the frame's uploads
+    auto Prepare(RenderGraph::PassBuilder &builder, uint32_t frameIndex, std::span<const RenderQueueEntry> retained)
+        -> void;
+
+    // Flushes the uploads and encodes the render pass
+    auto Record(wgpu::CommandEncoder &commandEncoder, const wgpu::TextureView &target, uint32_t frameIndex) -> void;
+
+    // Static group bookkeeping while the draw list is built
+    uint32_t m_group_count{0};
+    size_t m_group_cursor{0};
+
   public:
     Renderer(const wgpu::Instance &instance, wgpu::Adapter &adapter, wgpu::Device &device, wgpu::TextureFormat format,
-             glm::vec2 screenSize);
-    template <std::derived_from<render_layers::RenderLayer> Layer> auto pushRenderLayer(Ref<Layer> &renderLayer) -> void
+             glm::vec2 screenSize, uint32_t framesInFlight = 1);
+    template <std::derived_from<render_layers::RenderLayer> Layer>
+    auto pushRenderLayer(Ref<Layer> &renderLayer, int32_t order = 0) -> void
     {
-        m_render_layers.push_back(renderLayer.getLayer());
+        m_render_layers.push_back({renderLayer.getLayer(), order});
     }
 
-    auto Render(wgpu::SurfaceTexture &) -> void;
+    // Adds the pass drawing the retained queue (already sorted by key) merged
+    // with the layers pushed this frame into target, and returns the version
+    // it writes. Lower keys draw first; on equal keys retained layers come
+    // first, then push order. frameIndex selects the per-frame resources, see
+    // FramePacer. The draw list is built here; the graph records it.
+    auto AddPass(RenderGraph &graph, RenderGraphTexture target, uint32_t frameIndex = 0,
+                 std::span<const RenderQueueEntry> retained = {}) -> RenderGraphTexture;
+
+    // Draws into a transient texture created by the pass, e.g. as the input of
+    // post-processing passes
+    auto AddPass(RenderGraph &graph, const TransientTextureDesc &desc, uint32_t frameIndex = 0,
+                 std::span<const RenderQueueEntry> retained = {}) -> RenderGraphTexture;
+
+    // Call after the submit containing the pass; drops the pushed layers
+    auto EndFrame() -> void;
+
+    auto GetFormat() const -> wgpu::TextureFormat
+    {
+        return m_format;
+    }
 
     template <RenderableLayer Layer, typename... Args> auto CreateRenderLayer(Args &&...args) const -> Ref<Layer>
     {
@@ -92,10 +212,22 @@ class Renderer
         return Ref<Layer>(layer);
     }
 
+    // Merge consecutive layers that provide BatchGeometry into one draw
+    auto SetBatchingEnabled(bool enabled) -> void
+    {
+        m_batching_enabled = enabled;
+    }
+
+    // Counters of the last rendered frame
+    auto GetStats() const -> const RenderStats &
+    {
+        return m_stats;
+    }
+
     auto SetUniforms(const Uniforms &value) -> void
     {
         m_uniforms = value;
-        m_uniforms_dirty = true;
+        m_uniforms_dirty_slots = (1u << m_frames_in_flight) - 1;
     }
 
     ~Renderer();
@@ -0,0 +1,117 @@
+#include "DrawBatcher.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "CoreUtil.hpp"
+#include "PipelineCache.hpp"
+
+namespace wglib
+{
+namespace
+{
+constexpr uint64_t MIN_STREAM_SIZE = 64 * 1024;
+
+// Replaces buffer with a larger one, with room to grow, if it cannot hold size bytes
+template <wgpu::BufferUsage Usage>
+auto ensureCapacity(const wgpu::Device &device, wgpu::Buffer &buffer, uint64_t size) -> void
+{
+    if (buffer and buffer.GetSize() >= size)
+    {
+        return;
+    }
+    // The slot's previous frame has completed, dropping the old buffer is safe
+    const auto capacity = std::max(MIN_STREAM_SIZE, std::bit_ceil(size));
+    buffer = util::createBuffer<uint32_t, Usage>(device, capacity / sizeof(uint32_t));
+}
+} // namespace
+
+DrawBatcher::DrawBatcher(const wgpu::Device &device, wgpu::TextureFormat format,
+                         const wgpu::BindGroupLayout &bindGroupLayout)
+    : m_device(device)
+{
+    // Same shader as the layers it batches, reading the transform slot from
+    // a second vertex buffer instead of the instance index
+    const wgpu::VertexBufferLayout vertexBufferLayouts[2]{
+        render_layers::Vertex::getVertexBufferLayout(),
+        render_layers::VertexLayout<uint32_t>::Get<2>(),
+    };
+    m_pipeline = PipelineCache::Get(m_device).GetRenderPipeline({
+        .shaderPath = "../src/shaders/default.wgsl",
+        .vertexEntryPoint = "vertexBatched",
+        .vertexBuffers = vertexBufferLayouts,
+        .bindGroupLayouts = {&bindGroupLayout, 1},
+        .format = format,
+    });
+}
+
+auto DrawBatcher::Clear() -> void
+{
+    m_vertices.clear();
+    m_transforms.clear();
+    m_indices.clear();
+}
+
+auto DrawBatcher::Append(const render_layers::BatchGeometry &geometry) -> Run
+{
+    const auto baseVertex = static_cast<uint32_t>(m_vertices.size());
+    const Run run{.firstIndex = static_cast<uint32_t>(m_indices.size()),
+                  .indexCount = static_cast<uint32_t>(geometry.indices.size())};
+
+    m_vertices.insert(m_vertices.end(), geometry.vertices.begin(), geometry.vertices.end());
+    m_transforms.insert(m_transforms.end(), geometry.vertices.size(), geometry.transform);
+    // Rebase on the CPU so the whole stream can go out in a single draw
+    m_indices.reserve(m_indices.size() + geometry.indices.size());
+    for (const auto index : geometry.indices)
+    {
+        m_indices.push_back(baseVertex + index);
+    }
+    return run;
+}
+
+auto DrawBatcher::Upload(uint32_t frameIndex, UploadBelt &uploads) -> void
+{
+    if (m_indices.empty())
+    {
+        return;
+    }
+    auto &buffers = m_frame_buffers[frameIndex];
+    const auto vertexBytes = m_vertices.size() * sizeof(render_layers::Vertex);
+    const auto transformBytes = m_transforms.size() * sizeof(uint32_t);
+    // Halves the index stream whenever the frame's vertices fit 16-bit indices
+    buffers.indexFormat = render_layers::IndexFormatFor(m_vertices.size());
+    if (buffers.indexFormat == wgpu::IndexFormat::Uint16)
+    {
+        render_layers::NarrowIndices(m_indices, m_narrow_indices);
+    }
+    const auto indexBytes = buffers.indexFormat == wgpu::IndexFormat::Uint16
+                                ? m_narrow_indices.size() * sizeof(uint16_t)
+                                : m_indices.size() * sizeof(uint32_t);
+
+    ensureCapacity<wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst>(m_device, buffers.vertices, vertexBytes);
+    ensureCapacity<wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst>(m_device, buffers.transforms,
+                                                                           transformBytes);
+    ensureCapacity<wgpu::BufferUsage::Index | wgpu::BufferUsage::CopyDst>(m_device, buffers.indices, indexBytes);
+
+    uploads.Write<render_layers::Vertex>(buffers.vertices, 0, m_vertices);
+    uploads.Write<uint32_t>(buffers.transforms, 0, m_transforms);
+    if (buffers.indexFormat == wgpu::IndexFormat::Uint16)
+    {
+        uploads.Write<uint16_t>(buffers.indices, 0, m_narrow_indices);
+    }
+    else
+    {
+        uploads.Write<uint32_t>(buffers.indices, 0, m_indices);
+    }
+}
+
+auto DrawBatcher::Draw(render_layers::RenderEncoder &encoder, uint32_t frameIndex, const Run &run) const -> void
+{
+    const auto &buffers = m_frame_buffers[frameIndex];
+    encoder.SetPipeline(m_pipeline);
+    encoder.SetVertexBuffer(0, buffers.vertices);
+    encoder.SetVertexBuffer(1, buffers.transforms);
+    encoder.SetIndexBuffer(buffers.indices, buffers.indexFormat);
+    encoder.DrawIndexed(run.indexCount, 1, run.firstIndex);
+}
+} // namespace wglib
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "FramePacer.hpp"
+#include "UploadBelt.hpp"
+#include "render_layer/RenderLayer.hpp"
+#include "render_layer/Vertex.hpp"
+
+namespace wglib
+{
+// Collects the geometry of batchable layers into one vertex/index stream per
+// frame and draws contiguous ranges of it with the default shape pipeline.
+// A parallel stream carries each vertex's TransformBuffer slot.
+class DrawBatcher
+{
+  public:
+    struct Run
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+  private:
+    struct FrameBuffers
+    {
+        wgpu::Buffer vertices;
+        wgpu::Buffer transforms;
+        wgpu::Buffer indices;
+        wgpu::IndexFormat indexFormat{wgpu::IndexFormat::Uint32};
+    };
+
+    const wgpu::Device &m_device;
+    wgpu::RenderPipeline m_pipeline;
+    std::array<FrameBuffers, FramePacer::MAX_FRAMES_IN_FLIGHT> m_frame_buffers{};
+
+    std::vector<render_layers::Vertex> m_vertices;
+    std::vector<uint32_t> m_transforms;
+    std::vector<uint32_t> m_indices;
+    // m_indices as 16-bit, filled by Upload when the vertices allow it
+    std::vector<uint16_t> m_narrow_indices;
+
+  public:
+    DrawBatcher(const wgpu::Device &device, wgpu::TextureFormat format, const wgpu::BindGroupLayout &bindGroupLayout);
+
+    auto Clear() -> void;
+
+    // Appends a layer's geometry, returns the run covering it
+    auto Append(const render_layers::BatchGeometry &geometry) -> Run;
+
+    // Stages this frame's stream for the buffers of the given frame slot
+    auto Upload(uint32_t frameIndex, UploadBelt &uploads) -> void;
+
+    auto Draw(render_layers::RenderEncoder &encoder, uint32_t frameIndex, const Run &run) const -> void;
+};
+} // namespace wglib
@@ -0,0 +1,71 @@
+#include "FramePacer.hpp"
+
+#include <algorithm>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+FramePacer::FramePacer(const wgpu::Instance &instance, const wgpu::Device &device, uint32_t framesInFlight)
+    : m_instance(instance), m_device(device),
+      m_frames_in_flight(std::clamp<uint32_t>(framesInFlight, 1, MAX_FRAMES_IN_FLIGHT))
+{
+}
+
+auto FramePacer::wait(uint32_t slot) -> void
+{
+    auto &future = m_in_flight[slot];
+    if (future)
+    {
+        if (m_instance.WaitAny(*future, UINT64_MAX) != wgpu::WaitStatus::Success)
+        {
+            util::log("Failed to wait for frame in flight");
+        }
+        future.reset();
+    }
+
+    // Swapped out first, a callback may defer more work
+    auto deferred = std::move(m_deferred[slot]);
+    m_deferred[slot].clear();
+    for (auto &fn : deferred)
+    {
+        fn();
+    }
+}
+
+auto FramePacer::BeginFrame() -> uint32_t
+{
+    m_frame_index = static_cast<uint32_t>(m_frame_number % m_frames_in_flight);
+    wait(m_frame_index);
+    return m_frame_index;
+}
+
+auto FramePacer::EndFrame() -> void
+{
+    // On the web the browser paces frames and the main loop cannot block, so
+    // slots are reused without tracking completion.
+#ifndef __EMSCRIPTEN__
+    m_in_flight[m_frame_index] = m_device.GetQueue().OnSubmittedWorkDone(
+        wgpu::CallbackMode::WaitAnyOnly, [](wgpu::QueueWorkDoneStatus status, wgpu::StringView message) {
+            if (status != wgpu::QueueWorkDoneStatus::Success)
+            {
+                util::log("Frame work failed: {}", message.data);
+            }
+        });
+#endif
+    ++m_frame_number;
+}
+
+auto FramePacer::Defer(std::function<void()> fn) -> void
+{
+    m_deferred[m_frame_index].push_back(std::move(fn));
+}
+
+auto FramePacer::WaitIdle() -> void
+{
+    for (uint32_t slot = 0; slot < m_frames_in_flight; ++slot)
+    {
+        wait(slot);
+    }
+}
+} // namespace wglib
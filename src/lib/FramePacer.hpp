@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib
+{
+// Bounds how many frames the CPU may record ahead of the GPU. Each frame gets
+// a slot index; per-frame resources are kept in rings indexed by that slot and
+// BeginFrame blocks until the GPU has finished the frame that last used it.
+class FramePacer
+{
+  public:
+    constexpr static uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
+  private:
+    const wgpu::Instance &m_instance;
+    const wgpu::Device &m_device;
+    uint32_t m_frames_in_flight;
+    uint32_t m_frame_index{0};
+    uint64_t m_frame_number{0};
+    std::array<std::optional<wgpu::Future>, MAX_FRAMES_IN_FLIGHT> m_in_flight{};
+    std::array<std::vector<std::function<void()>>, MAX_FRAMES_IN_FLIGHT> m_deferred{};
+
+    auto wait(uint32_t slot) -> void;
+
+  public:
+    FramePacer(const wgpu::Instance &instance, const wgpu::Device &device, uint32_t framesInFlight);
+
+    // Waits until the slot of the next frame is free and returns it
+    auto BeginFrame() -> uint32_t;
+
+    // Call after the frame's last submit
+    auto EndFrame() -> void;
+
+    // Runs fn once the current frame has completed on the GPU, e.g. to release
+    // resources it may still read. Call between BeginFrame and EndFrame.
+    auto Defer(std::function<void()> fn) -> void;
+
+    // Waits for every frame in flight
+    auto WaitIdle() -> void;
+
+    auto FrameIndex() const -> uint32_t
+    {
+        return m_frame_index;
+    }
+
+    auto FrameNumber() const -> uint64_t
+    {
+        return m_frame_number;
+    }
+
+    auto FramesInFlight() const -> uint32_t
+    {
+        return m_frames_in_flight;
+    }
+};
+} // namespace wglib
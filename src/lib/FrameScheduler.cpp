@@ -0,0 +1,84 @@
+#include "FrameScheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wglib
+{
+auto FrameScheduler::SetTickRate(double hz) -> void
+{
+    m_tick_interval = hz > 0.0 ? 1.0 / hz : 0.0;
+    m_tick_accumulator = 0.0;
+}
+
+auto FrameScheduler::SetRenderRate(double hz) -> void
+{
+    m_render_interval = hz > 0.0 ? 1.0 / hz : 0.0;
+    m_render_accumulator = 0.0;
+}
+
+auto FrameScheduler::Advance(double elapsed) -> FrameSchedule
+{
+    elapsed = std::max(elapsed, 0.0);
+    m_since_render += elapsed;
+
+    FrameSchedule schedule{.ticks = 0, .render = false, .renderDelta = 0.0, .alpha = 1.0};
+
+    if (HasFixedTick())
+    {
+        m_tick_accumulator += elapsed;
+        while (m_tick_accumulator >= m_tick_interval and schedule.ticks < MAX_TICKS_PER_ADVANCE)
+        {
+            m_tick_accumulator -= m_tick_interval;
+            ++schedule.ticks;
+        }
+        if (schedule.ticks == MAX_TICKS_PER_ADVANCE)
+        {
+            // Drop whole ticks we could not catch up on, keep the phase
+            m_tick_accumulator = std::fmod(m_tick_accumulator, m_tick_interval);
+        }
+        schedule.alpha = m_tick_accumulator / m_tick_interval;
+    }
+
+    if (m_render_interval <= 0.0)
+    {
+        schedule.render = true;
+    }
+    else
+    {
+        m_render_accumulator += elapsed;
+        if (m_render_accumulator >= m_render_interval)
+        {
+            schedule.render = true;
+            m_render_accumulator -= m_render_interval;
+            // More than a frame behind: skip the missed frames rather than
+            // rendering back to back
+            if (m_render_accumulator >= m_render_interval)
+            {
+                m_render_accumulator = 0.0;
+            }
+        }
+    }
+
+    if (schedule.render)
+    {
+        schedule.renderDelta = m_since_render;
+        m_since_render = 0.0;
+    }
+    return schedule;
+}
+
+auto FrameScheduler::TimeUntilNextEvent() const -> double
+{
+    if (m_render_interval <= 0.0)
+    {
+        return 0.0;
+    }
+    auto wait = m_render_interval - m_render_accumulator;
+    if (HasFixedTick())
+    {
+        wait = std::min(wait, m_tick_interval - m_tick_accumulator);
+    }
+    return std::max(wait, 0.0);
+}
+} // namespace wglib
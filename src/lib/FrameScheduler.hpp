@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace wglib
+{
+struct FrameSchedule
+{
+    // Fixed simulation ticks that are due
+    uint32_t ticks;
+    // Whether a frame should be rendered
+    bool render;
+    // Time since the last rendered frame, valid when render is set
+    double renderDelta;
+    // Fraction of a tick the simulation clock is ahead of the last tick, for
+    // interpolating between the previous and current simulation state
+    double alpha;
+};
+
+// Runs a fixed simulation tick and an independent render rate off one clock.
+// Leftover time is carried over between calls instead of being dropped.
+class FrameScheduler
+{
+    double m_tick_interval{0.0};
+    double m_render_interval{0.0};
+    double m_tick_accumulator{0.0};
+    double m_render_accumulator{0.0};
+    double m_since_render{0.0};
+
+  public:
+    // Upper bound on ticks run for one Advance call, so a long stall cannot
+    // snowball into ever longer catch-up frames
+    constexpr static uint32_t MAX_TICKS_PER_ADVANCE = 8;
+
+    // 0 disables the fixed tick
+    auto SetTickRate(double hz) -> void;
+
+    // 0 renders on every Advance call
+    auto SetRenderRate(double hz) -> void;
+
+    auto TickInterval() const -> double
+    {
+        return m_tick_interval;
+    }
+
+    auto RenderInterval() const -> double
+    {
+        return m_render_interval;
+    }
+
+    auto HasFixedTick() const -> bool
+    {
+        return m_tick_interval > 0.0;
+    }
+
+    auto Advance(double elapsed) -> FrameSchedule;
+
+    // Seconds until the next tick or frame is due, 0 when one already is or
+    // when rendering is unthrottled
+    auto TimeUntilNextEvent() const -> double;
+};
+} // namespace wglib
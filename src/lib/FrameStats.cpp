@@ -0,0 +1,77 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+namespace
+{
+auto elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) -> double
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// Nearest-rank percentile over sorted samples
+auto percentile(const std::vector<double> &sorted, double p) -> double
+{
+    const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+} // namespace
+
+auto FrameStats::BeginFrame() -> void
+{
+    m_frame_start = Clock::now();
+}
+
+auto FrameStats::EndFrame(const wgpu::Queue &queue) -> void
+{
+    const auto submitted = Clock::now();
+
+    size_t index;
+    {
+        std::scoped_lock lock(m_state->mutex);
+        index = m_state->timings.size();
+        m_state->timings.push_back({.cpuMs = elapsedMs(m_frame_start, submitted), .gpuMs = 0.0});
+    }
+
+    queue.OnSubmittedWorkDone(wgpu::CallbackMode::AllowSpontaneous,
+                              [state = m_state, index, submitted](wgpu::QueueWorkDoneStatus status,
+                                                                  wgpu::StringView message) {
+                                  if (status != wgpu::QueueWorkDoneStatus::Success)
+                                  {
+                                      util::log("Frame work failed: {}", message.data);
+                                      return;
+                                  }
+                                  const auto done = Clock::now();
+                                  std::scoped_lock lock(state->mutex);
+                                  state->timings[index].gpuMs = elapsedMs(submitted, done);
+                              });
+}
+
+auto FrameStats::Timings() const -> std::vector<FrameTiming>
+{
+    std::scoped_lock lock(m_state->mutex);
+    return m_state->timings;
+}
+
+auto FrameStats::Summarize(std::vector<double> samples) -> TimingSummary
+{
+    if (samples.empty())
+    {
+        return {};
+    }
+    std::ranges::sort(samples);
+    return {
+        .mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size()),
+        .p50 = percentile(samples, 50.0),
+        .p95 = percentile(samples, 95.0),
+        .p99 = percentile(samples, 99.0),
+        .max = samples.back(),
+    };
+}
+} // namespace wglib
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib
+{
+struct FrameTiming
+{
+    // CPU time spent in compute dispatch, event processing, rendering and the update callback
+    double cpuMs;
+    // Time from the frame's submit until the queue reports the work as done
+    double gpuMs;
+};
+
+struct TimingSummary
+{
+    double mean, p50, p95, p99, max;
+};
+
+// Records per-frame CPU and GPU completion times. GPU completion is observed
+// through OnSubmittedWorkDone, so it is only as precise as callback delivery.
+class FrameStats
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<FrameTiming> timings;
+    };
+
+    std::shared_ptr<State> m_state{std::make_shared<State>()};
+    Clock::time_point m_frame_start;
+
+  public:
+    auto BeginFrame() -> void;
+
+    // Call after the frame's last submit
+    auto EndFrame(const wgpu::Queue &queue) -> void;
+
+    auto Timings() const -> std::vector<FrameTiming>;
+
+    static auto Summarize(std::vector<double> samples) -> TimingSummary;
+};
+} // namespace wglib
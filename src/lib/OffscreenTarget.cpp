@@ -0,0 +1,102 @@
+#include "OffscreenTarget.hpp"
+
+#include <cstring>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+OffscreenTarget::OffscreenTarget(uint32_t width, uint32_t height, const wgpu::Device &device,
+                                 wgpu::TextureFormat format)
+    : m_width(width), m_height(height), m_format(format)
+{
+    const wgpu::TextureDescriptor desc{
+        .label = "OffscreenTarget",
+        .usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc |
+                 wgpu::TextureUsage::TextureBinding,
+        .dimension = wgpu::TextureDimension::e2D,
+        .size = {m_width, m_height, 1},
+        .format = m_format,
+    };
+    m_texture = device.CreateTexture(&desc);
+    m_view = m_texture.CreateView();
+}
+
+auto OffscreenTarget::width() const -> uint32_t
+{
+    return m_width;
+}
+
+auto OffscreenTarget::height() const -> uint32_t
+{
+    return m_height;
+}
+
+auto OffscreenTarget::format() const -> wgpu::TextureFormat
+{
+    return m_format;
+}
+
+auto OffscreenTarget::texture() const -> const wgpu::Texture &
+{
+    return m_texture;
+}
+
+auto OffscreenTarget::view() const -> const wgpu::TextureView &
+{
+    return m_view;
+}
+
+auto OffscreenTarget::readback(const wgpu::Instance &instance, const wgpu::Device &device) const
+    -> std::vector<uint8_t>
+{
+    constexpr uint32_t bytesPerPixel = 4;
+    // Texture to buffer copies need rows aligned to 256 bytes
+    const uint32_t packedRow = m_width * bytesPerPixel;
+    const uint32_t paddedRow = util::divCeil(packedRow, 256u) * 256u;
+    const uint64_t size = static_cast<uint64_t>(paddedRow) * m_height;
+
+    const wgpu::BufferDescriptor bufferDesc{
+        .usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst,
+        .size = size,
+    };
+    const auto staging = device.CreateBuffer(&bufferDesc);
+
+    const wgpu::TexelCopyTextureInfo source{.texture = m_texture};
+    const wgpu::TexelCopyBufferInfo destination{
+        .layout = {.bytesPerRow = paddedRow, .rowsPerImage = m_height},
+        .buffer = staging,
+    };
+    const wgpu::Extent3D extent{m_width, m_height, 1};
+
+    auto encoder = device.CreateCommandEncoder();
+    encoder.CopyTextureToBuffer(&source, &destination, &extent);
+    const auto commandBuffer = encoder.Finish();
+    device.GetQueue().Submit(1, &commandBuffer);
+
+    auto mapped = false;
+    const auto future = staging.MapAsync(wgpu::MapMode::Read, 0, size, wgpu::CallbackMode::WaitAnyOnly,
+                                         [&](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+                                             if (status != wgpu::MapAsyncStatus::Success)
+                                             {
+                                                 util::log("Failed to map offscreen readback: {}", message.data);
+                                                 return;
+                                             }
+                                             mapped = true;
+                                         });
+    if (instance.WaitAny(future, UINT64_MAX) != wgpu::WaitStatus::Success or not mapped)
+    {
+        return {};
+    }
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(packedRow) * m_height);
+    const auto *src = static_cast<const uint8_t *>(staging.GetConstMappedRange(0, size));
+    for (uint32_t row = 0; row < m_height; ++row)
+    {
+        std::memcpy(pixels.data() + static_cast<size_t>(row) * packedRow,
+                    src + static_cast<size_t>(row) * paddedRow, packedRow);
+    }
+    staging.Unmap();
+    return pixels;
+}
+} // namespace wglib
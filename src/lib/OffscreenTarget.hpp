@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib
+{
+// Owned render target used in place of a window surface when the engine runs
+// headless. The texture can be copied back to the CPU after a frame.
+class OffscreenTarget
+{
+    uint32_t m_width, m_height;
+    wgpu::TextureFormat m_format;
+    wgpu::Texture m_texture;
+    wgpu::TextureView m_view;
+
+  public:
+    constexpr static auto DEFAULT_FORMAT = wgpu::TextureFormat::RGBA8Unorm;
+
+    OffscreenTarget(uint32_t width, uint32_t height, const wgpu::Device &device,
+                    wgpu::TextureFormat format = DEFAULT_FORMAT);
+
+    auto width() const -> uint32_t;
+
+    auto height() const -> uint32_t;
+
+    auto format() const -> wgpu::TextureFormat;
+
+    auto texture() const -> const wgpu::Texture &;
+
+    auto view() const -> const wgpu::TextureView &;
+
+    // Copies the texture into a staging buffer and blocks until it is mapped.
+    // Returns tightly packed rows of 4 bytes per pixel.
+    auto readback(const wgpu::Instance &instance, const wgpu::Device &device) const -> std::vector<uint8_t>;
+};
+} // namespace wglib
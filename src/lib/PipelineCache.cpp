@@ -0,0 +1,323 @@
+#include "PipelineCache.hpp"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+namespace
+{
+// Cache key built field by field, so struct padding never reaches it. The
+// maps compare whole keys, so a hash collision can never return an object
+// created for another descriptor.
+class CacheKey
+{
+    std::string m_bytes;
+
+    auto bytes(const void *data, size_t size) -> CacheKey &
+    {
+        m_bytes.append(static_cast<const char *>(data), size);
+        return *this;
+    }
+
+  public:
+    template <typename T>
+        requires std::is_arithmetic_v<T> or std::is_enum_v<T> or std::is_pointer_v<T>
+    auto add(T value) -> CacheKey &
+    {
+        return bytes(&value, sizeof(value));
+    }
+
+    auto add(std::string_view text) -> CacheKey &
+    {
+        add(text.size());
+        return bytes(text.data(), text.size());
+    }
+
+    auto addEntryPoint(const char *entryPoint) -> CacheKey &
+    {
+        return entryPoint ? add(std::string_view{entryPoint}) : add(SIZE_MAX);
+    }
+
+    auto take() -> std::string
+    {
+        return std::move(m_bytes);
+    }
+};
+
+auto registry() -> std::unordered_map<WGPUDevice, std::unique_ptr<PipelineCache>> &
+{
+    static std::unordered_map<WGPUDevice, std::unique_ptr<PipelineCache>> caches;
+    return caches;
+}
+
+template <typename Map> auto evictStale(Map &map, uint64_t frame, uint64_t maxAge) -> void
+{
+    std::erase_if(map, [&](const auto &item) { return frame - item.second.lastUsedFrame > maxAge; });
+}
+} // namespace
+
+PipelineCache::PipelineCache(wgpu::Device device) : m_device(std::move(device))
+{
+}
+
+auto PipelineCache::Get(const wgpu::Device &device) -> PipelineCache &
+{
+    auto &cache = registry()[device.Get()];
+    if (not cache)
+    {
+        cache = std::make_unique<PipelineCache>(device);
+    }
+    return *cache;
+}
+
+auto PipelineCache::Release(const wgpu::Device &device) -> void
+{
+    registry().erase(device.Get());
+}
+
+auto PipelineCache::shaderModule(std::string_view path, std::string_view prelude) -> const ShaderModuleEntry &
+{
+    // Every prelude of a file is a module of its own
+    auto key = std::string{path};
+    if (not prelude.empty())
+    {
+        key.append(1, '\0').append(prelude);
+    }
+    if (const auto it = m_modules_by_path.find(key); it != m_modules_by_path.end())
+    {
+        return it->second;
+    }
+
+    // Different paths with the same source still share one module
+    auto source = std::string{prelude} + util::readFile(path);
+    auto &module = m_modules_by_source[source];
+    if (not module)
+    {
+        wgpu::ShaderSourceWGSL wgsl{{.code = source.c_str()}};
+        wgpu::ShaderModuleDescriptor descriptor{.nextInChain = &wgsl};
+        module = m_device.CreateShaderModule(&descriptor);
+    }
+    return m_modules_by_path[std::move(key)] = {.module = module};
+}
+
+auto PipelineCache::pipelineLayout(std::span<const wgpu::BindGroupLayout> bindGroupLayouts) const
+    -> wgpu::PipelineLayout
+{
+    if (bindGroupLayouts.empty())
+    {
+        return nullptr;
+    }
+    const wgpu::PipelineLayoutDescriptor descriptor{
+        .bindGroupLayoutCount = bindGroupLayouts.size(),
+        .bindGroupLayouts = bindGroupLayouts.data(),
+    };
+    return m_device.CreatePipelineLayout(&descriptor);
+}
+
+auto PipelineCache::GetShaderModule(std::string_view path) -> wgpu::ShaderModule
+{
+    return shaderModule(path).module;
+}
+
+auto PipelineCache::GetRenderPipeline(const RenderPipelineInfo &info) -> wgpu::RenderPipeline
+{
+    const auto &shader = shaderModule(info.shaderPath);
+
+    // Modules are shared per source, so the handle stands for the source
+    CacheKey key;
+    key.add(shader.module.Get())
+        .addEntryPoint(info.vertexEntryPoint)
+        .addEntryPoint(info.fragmentEntryPoint)
+        .add(info.format)
+        .add(info.topology);
+    for (const auto &buffer : info.vertexBuffers)
+    {
+        key.add(buffer.stepMode).add(buffer.arrayStride).add(buffer.attributeCount);
+        for (size_t i = 0; i < buffer.attributeCount; ++i)
+        {
+            const auto &attribute = buffer.attributes[i];
+            key.add(attribute.format).add(attribute.offset).add(attribute.shaderLocation);
+        }
+    }
+    for (const auto &layout : info.bindGroupLayouts)
+    {
+        key.add(layout.Get());
+    }
+    key.add(info.blend != nullptr);
+    if (info.blend)
+    {
+        for (const auto &component : {info.blend->color, info.blend->alpha})
+        {
+            key.add(component.operation).add(component.srcFactor).add(component.dstFactor);
+        }
+    }
+
+    auto &pipeline = m_render_pipelines[key.take()];
+    if (pipeline)
+    {
+        ++m_stats.hits;
+        return pipeline;
+    }
+    ++m_stats.misses;
+
+    const wgpu::ColorTargetState colorTarget{.format = info.format, .blend = info.blend};
+    wgpu::FragmentState fragmentState{.module = shader.module, .targetCount = 1, .targets = &colorTarget};
+    wgpu::RenderPipelineDescriptor descriptor{
+        .layout = pipelineLayout(info.bindGroupLayouts),
+        .vertex =
+            {
+                .module = shader.module,
+                .bufferCount = info.vertexBuffers.size(),
+                .buffers = info.vertexBuffers.data(),
+            },
+        .primitive = {.topology = info.topology},
+        .fragment = &fragmentState,
+    };
+    if (info.vertexEntryPoint)
+    {
+        descriptor.vertex.entryPoint = info.vertexEntryPoint;
+    }
+    if (info.fragmentEntryPoint)
+    {
+        fragmentState.entryPoint = info.fragmentEntryPoint;
+    }
+    pipeline = m_device.CreateRenderPipeline(&descriptor);
+    util::log("Created render pipeline for {}", info.shaderPath);
+    return pipeline;
+}
+
+auto PipelineCache::GetComputePipeline(const ComputePipelineInfo &info) -> wgpu::ComputePipeline
+{
+    const auto &shader = shaderModule(info.shaderPath, info.prelude);
+
+    CacheKey key;
+    key.add(shader.module.Get()).addEntryPoint(info.entryPoint);
+    for (const auto &layout : info.bindGroupLayouts)
+    {
+        key.add(layout.Get());
+    }
+
+    auto &pipeline = m_compute_pipelines[key.take()];
+    if (pipeline)
+    {
+        ++m_stats.hits;
+        return pipeline;
+    }
+    ++m_stats.misses;
+
+    wgpu::ComputePipelineDescriptor descriptor{
+        .layout = pipelineLayout(info.bindGroupLayouts),
+        .compute = {.module = shader.module},
+    };
+    if (info.entryPoint)
+    {
+        descriptor.compute.entryPoint = info.entryPoint;
+    }
+    pipeline = m_device.CreateComputePipeline(&descriptor);
+    util::log("Created compute pipeline for {}", info.shaderPath);
+    return pipeline;
+}
+
+auto PipelineCache::GetBindGroupLayout(std::span<const wgpu::BindGroupLayoutEntry> entries) -> wgpu::BindGroupLayout
+{
+    CacheKey key;
+    for (const auto &entry : entries)
+    {
+        key.add(entry.binding)
+            .add(entry.visibility)
+            .add(entry.buffer.type)
+            .add(static_cast<bool>(entry.buffer.hasDynamicOffset))
+            .add(entry.buffer.minBindingSize)
+            .add(entry.sampler.type)
+            .add(entry.texture.sampleType)
+            .add(entry.texture.viewDimension)
+            .add(static_cast<bool>(entry.texture.multisampled))
+            .add(entry.storageTexture.access)
+            .add(entry.storageTexture.format)
+            .add(entry.storageTexture.viewDimension);
+    }
+
+    auto &layout = m_bind_group_layouts[key.take()];
+    if (layout)
+    {
+        ++m_stats.hits;
+        return layout;
+    }
+    ++m_stats.misses;
+
+    const wgpu::BindGroupLayoutDescriptor descriptor{.entryCount = entries.size(), .entries = entries.data()};
+    layout = m_device.CreateBindGroupLayout(&descriptor);
+    return layout;
+}
+
+auto PipelineCache::GetBindGroup(const wgpu::BindGroupLayout &layout, std::span<const wgpu::BindGroupEntry> entries)
+    -> wgpu::BindGroup
+{
+    CacheKey key;
+    key.add(layout.Get());
+    for (const auto &entry : entries)
+    {
+        key.add(entry.binding)
+            .add(entry.buffer.Get())
+            .add(entry.offset)
+            .add(entry.size)
+            .add(entry.sampler.Get())
+            .add(entry.textureView.Get());
+    }
+
+    auto [it, inserted] = m_bind_groups.try_emplace(key.take());
+    it->second.lastUsedFrame = m_frame;
+    if (not inserted)
+    {
+        ++m_stats.hits;
+        return it->second.object;
+    }
+    ++m_stats.misses;
+
+    const wgpu::BindGroupDescriptor descriptor{
+        .layout = layout,
+        .entryCount = entries.size(),
+        .entries = entries.data(),
+    };
+    it->second.object = m_device.CreateBindGroup(&descriptor);
+    return it->second.object;
+}
+
+auto PipelineCache::GetTextureView(const wgpu::Texture &texture) -> wgpu::TextureView
+{
+    auto [it, inserted] = m_texture_views.try_emplace(texture.Get());
+    it->second.lastUsedFrame = m_frame;
+    if (not inserted)
+    {
+        ++m_stats.hits;
+        return it->second.object.second;
+    }
+    ++m_stats.misses;
+
+    it->second.object = {texture, texture.CreateView()};
+    return it->second.object.second;
+}
+
+auto PipelineCache::EndFrame() -> void
+{
+    ++m_frame;
+    evictStale(m_bind_groups, m_frame, EVICT_AFTER_FRAMES);
+    evictStale(m_texture_views, m_frame, EVICT_AFTER_FRAMES);
+}
+
+auto PipelineCache::Stats() const -> PipelineCacheStats
+{
+    auto stats = m_stats;
+    stats.shaderModules = m_modules_by_source.size();
+    stats.renderPipelines = m_render_pipelines.size();
+    stats.computePipelines = m_compute_pipelines.size();
+    stats.bindGroups = m_bind_groups.size();
+    stats.textureViews = m_texture_views.size();
+    return stats;
+}
+} // namespace wglib
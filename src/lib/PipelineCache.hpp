@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib
+{
+struct RenderPipelineInfo
+{
+    std::string_view shaderPath;
+    // nullptr picks the module's only entry point of that stage
+    const char *vertexEntryPoint{nullptr};
+    const char *fragmentEntryPoint{nullptr};
+    std::span<const wgpu::VertexBufferLayout> vertexBuffers{};
+    std::span<const wgpu::BindGroupLayout> bindGroupLayouts{};
+    wgpu::TextureFormat format{wgpu::TextureFormat::Undefined};
+    wgpu::PrimitiveTopology topology{wgpu::PrimitiveTopology::TriangleList};
+    const wgpu::BlendState *blend{nullptr};
+};
+
+struct ComputePipelineInfo
+{
+    std::string_view shaderPath;
+    const char *entryPoint{nullptr};
+    // Empty lets WebGPU derive the layout from the shader
+    std::span<const wgpu::BindGroupLayout> bindGroupLayouts{};
+    // WGSL prepended to the file, such as the aliases and functions that
+    // specialize a generic kernel for one element type
+    std::string_view prelude{};
+};
+
+struct PipelineCacheStats
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    size_t shaderModules{0};
+    size_t renderPipelines{0};
+    size_t computePipelines{0};
+    size_t bindGroups{0};
+    size_t textureViews{0};
+};
+
+// Device-level cache of shader modules, pipelines, bind groups and default
+// texture views. Pipelines are keyed by the shader source, entry points,
+// target format, vertex layout and bind group layouts, so every layer
+// of a kind shares one pipeline. Bind groups and texture views are keyed by
+// the handles they reference and dropped after EVICT_AFTER_FRAMES unused
+// frames. Only used from the thread driving the engine.
+class PipelineCache
+{
+  public:
+    constexpr static uint64_t EVICT_AFTER_FRAMES = 16;
+
+  private:
+    template <typename T> struct Entry
+    {
+        T object;
+        uint64_t lastUsedFrame;
+    };
+
+    struct ShaderModuleEntry
+    {
+        wgpu::ShaderModule module;
+    };
+
+    wgpu::Device m_device;
+    uint64_t m_frame{0};
+    PipelineCacheStats m_stats{};
+
+    std::unordered_map<std::string, ShaderModuleEntry> m_modules_by_path;
+    std::unordered_map<std::string, wgpu::ShaderModule> m_modules_by_source;
+    // Keyed by the descriptor fields that define the object, see CacheKey
+    std::unordered_map<std::string, wgpu::RenderPipeline> m_render_pipelines;
+    std::unordered_map<std::string, wgpu::ComputePipeline> m_compute_pipelines;
+    std::unordered_map<std::string, wgpu::BindGroupLayout> m_bind_group_layouts;
+    std::unordered_map<std::string, Entry<wgpu::BindGroup>> m_bind_groups;
+    // Keyed by texture handle; the entry keeps the texture alive so the key
+    // cannot be reused by another texture while cached
+    std::unordered_map<WGPUTexture, Entry<std::pair<wgpu::Texture, wgpu::TextureView>>> m_texture_views;
+
+    auto shaderModule(std::string_view path, std::string_view prelude = {}) -> const ShaderModuleEntry &;
+    auto pipelineLayout(std::span<const wgpu::BindGroupLayout> bindGroupLayouts) const -> wgpu::PipelineLayout;
+
+  public:
+    explicit PipelineCache(wgpu::Device device);
+
+    // One cache per device, created on first use
+    static auto Get(const wgpu::Device &device) -> PipelineCache &;
+
+    // Drops the device's cache; call before the device is destroyed
+    static auto Release(const wgpu::Device &device) -> void;
+
+    auto GetShaderModule(std::string_view path) -> wgpu::ShaderModule;
+
+    auto GetRenderPipeline(const RenderPipelineInfo &info) -> wgpu::RenderPipeline;
+
+    auto GetComputePipeline(const ComputePipelineInfo &info) -> wgpu::ComputePipeline;
+
+    auto GetBindGroupLayout(std::span<const wgpu::BindGroupLayoutEntry> entries) -> wgpu::BindGroupLayout;
+
+    auto GetBindGroup(const wgpu::BindGroupLayout &layout, std::span<const wgpu::BindGroupEntry> entries)
+        -> wgpu::BindGroup;
+
+    // Default view of the whole texture
+    auto GetTextureView(const wgpu::Texture &texture) -> wgpu::TextureView;
+
+    // Advances the frame counter and evicts stale bind groups and views
+    auto EndFrame() -> void;
+
+    auto Stats() const -> PipelineCacheStats;
+};
+} // namespace wglib
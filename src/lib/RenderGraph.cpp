@@ -0,0 +1,359 @@
+#include "RenderGraph.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <utility>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+RenderGraph::RenderGraph(wgpu::Device device) : m_device(std::move(device))
+{
+}
+
+auto RenderGraph::PassBuilder::Create(std::string_view name, const TransientTextureDesc &desc) -> RenderGraphTexture
+{
+    return {.index = m_graph.createTransient(m_pass, name, desc), .version = 0};
+}
+
+auto RenderGraph::PassBuilder::Import(std::string_view name, const wgpu::Texture &texture) -> RenderGraphTexture
+{
+    return m_graph.ImportTexture(name, texture);
+}
+
+auto RenderGraph::PassBuilder::Import(std::string_view name, const wgpu::Buffer &buffer) -> RenderGraphBuffer
+{
+    return m_graph.ImportBuffer(name, buffer);
+}
+
+auto RenderGraph::PassBuilder::Read(RenderGraphTexture texture) -> RenderGraphTexture
+{
+    m_graph.read(m_pass, texture.index, texture.version);
+    return texture;
+}
+
+auto RenderGraph::PassBuilder::Read(RenderGraphBuffer buffer) -> RenderGraphBuffer
+{
+    m_graph.read(m_pass, buffer.index, buffer.version);
+    return buffer;
+}
+
+auto RenderGraph::PassBuilder::Write(RenderGraphTexture texture) -> RenderGraphTexture
+{
+    return {.index = texture.index, .version = m_graph.write(m_pass, texture.index, texture.version)};
+}
+
+auto RenderGraph::PassBuilder::Write(RenderGraphBuffer buffer) -> RenderGraphBuffer
+{
+    return {.index = buffer.index, .version = m_graph.write(m_pass, buffer.index, buffer.version)};
+}
+
+auto RenderGraph::PassBuilder::SideEffect() -> void
+{
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+auto RenderGraph::Resources::Texture(RenderGraphTexture texture) const -> const wgpu::Texture &
+{
+    return m_graph.m_resources[texture.index].texture;
+}
+
+auto RenderGraph::Resources::View(RenderGraphTexture texture) const -> const wgpu::TextureView &
+{
+    return m_graph.m_resources[texture.index].view;
+}
+
+auto RenderGraph::Resources::Buffer(RenderGraphBuffer buffer) const -> const wgpu::Buffer &
+{
+    return m_graph.m_resources[buffer.index].buffer;
+}
+
+auto RenderGraph::ImportTexture(std::string_view name, const wgpu::Texture &texture, const wgpu::TextureView &view)
+    -> RenderGraphTexture
+{
+    const auto [it, inserted] =
+        m_imported_textures.try_emplace(texture.Get(), static_cast<uint32_t>(m_resources.size()));
+    if (inserted)
+    {
+        m_resources.push_back({
+            .name = std::string(name),
+            .imported = true,
+            .versions = {Version{}},
+            .texture = texture,
+            .view = view ? view : texture.CreateView(),
+        });
+    }
+    const auto &resource = m_resources[it->second];
+    return {.index = it->second, .version = static_cast<uint32_t>(resource.versions.size() - 1)};
+}
+
+auto RenderGraph::ImportBuffer(std::string_view name, const wgpu::Buffer &buffer) -> RenderGraphBuffer
+{
+    const auto [it, inserted] =
+        m_imported_buffers.try_emplace(buffer.Get(), static_cast<uint32_t>(m_resources.size()));
+    if (inserted)
+    {
+        m_resources.push_back({
+            .name = std::string(name),
+            .imported = true,
+            .versions = {Version{}},
+            .buffer = buffer,
+        });
+    }
+    const auto &resource = m_resources[it->second];
+    return {.index = it->second, .version = static_cast<uint32_t>(resource.versions.size() - 1)};
+}
+
+auto RenderGraph::createTransient(uint32_t pass, std::string_view name, const TransientTextureDesc &desc) -> uint32_t
+{
+    const auto index = static_cast<uint32_t>(m_resources.size());
+    m_resources.push_back({
+        .name = std::string(name),
+        .imported = false,
+        .versions = {Version{.producer = pass}},
+        .desc = desc,
+    });
+    m_passes[pass].transients.push_back(index);
+    return index;
+}
+
+auto RenderGraph::read(uint32_t pass, uint32_t resource, uint32_t version) -> void
+{
+    auto &r = m_resources[resource];
+    assert(version < r.versions.size() && "Reading a version that was never written");
+    auto &p = m_passes[pass];
+
+    auto &v = r.versions[version];
+    v.readers.push_back(pass);
+    if (v.producer != NO_PASS and v.producer != pass)
+    {
+        p.dependencies.push_back(v.producer);
+    }
+    // The version was overwritten already: read it before the overwrite
+    if (version + 1 < r.versions.size())
+    {
+        const auto overwriter = r.versions[version + 1].producer;
+        if (overwriter != pass)
+        {
+            m_passes[overwriter].after.push_back(pass);
+        }
+    }
+    if (not r.imported)
+    {
+        p.transients.push_back(resource);
+    }
+}
+
+auto RenderGraph::write(uint32_t pass, uint32_t resource, uint32_t version) -> uint32_t
+{
+    auto &r = m_resources[resource];
+    assert(version + 1 == r.versions.size() && "Only the latest version of a resource can be written");
+    auto &p = m_passes[pass];
+
+    const auto &v = r.versions[version];
+    // The pass may load what was there, and must not run before it was written
+    if (v.producer != NO_PASS and v.producer != pass)
+    {
+        p.dependencies.push_back(v.producer);
+    }
+    for (const auto reader : v.readers)
+    {
+        if (reader != pass)
+        {
+            p.after.push_back(reader);
+        }
+    }
+    r.versions.push_back({.producer = pass});
+    if (r.imported)
+    {
+        p.writesImported = true;
+    }
+    else
+    {
+        p.transients.push_back(resource);
+    }
+    return version + 1;
+}
+
+auto RenderGraph::schedule() -> std::vector<uint32_t>
+{
+    const auto passCount = static_cast<uint32_t>(m_passes.size());
+
+    // Keep what reaches the imported resources or has side effects
+    std::vector<bool> live(passCount, false);
+    std::vector<uint32_t> stack;
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        if (m_passes[pass].sideEffect or m_passes[pass].writesImported)
+        {
+            live[pass] = true;
+            stack.push_back(pass);
+        }
+    }
+    while (not stack.empty())
+    {
+        const auto pass = stack.back();
+        stack.pop_back();
+        for (const auto dependency : m_passes[pass].dependencies)
+        {
+            if (not live[dependency])
+            {
+                live[dependency] = true;
+                stack.push_back(dependency);
+            }
+        }
+    }
+
+    // Kahn's algorithm, taking the earliest added pass that is ready
+    std::vector<std::vector<uint32_t>> successors(passCount);
+    std::vector<uint32_t> pending(passCount, 0);
+    uint32_t liveCount = 0;
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        if (not live[pass])
+        {
+            continue;
+        }
+        ++liveCount;
+        const auto addEdge = [&](uint32_t before) {
+            if (live[before])
+            {
+                successors[before].push_back(pass);
+                ++pending[pass];
+            }
+        };
+        std::ranges::for_each(m_passes[pass].dependencies, addEdge);
+        std::ranges::for_each(m_passes[pass].after, addEdge);
+    }
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+    for (uint32_t pass = 0; pass < passCount; ++pass)
+    {
+        if (live[pass] and pending[pass] == 0)
+        {
+            ready.push(pass);
+        }
+    }
+    std::vector<uint32_t> order;
+    order.reserve(liveCount);
+    while (not ready.empty())
+    {
+        const auto pass = ready.top();
+        ready.pop();
+        order.push_back(pass);
+        for (const auto next : successors[pass])
+        {
+            if (--pending[next] == 0)
+            {
+                ready.push(next);
+            }
+        }
+    }
+
+    if (order.size() != liveCount)
+    {
+        // A pass read a version that a pass it depends on had overwritten
+        util::log("RenderGraph: dependency cycle, skipping {} passes", liveCount - order.size());
+    }
+    m_stats.passes = static_cast<uint32_t>(order.size());
+    m_stats.culledPasses = passCount - liveCount;
+    return order;
+}
+
+auto RenderGraph::allocateTransients(const std::vector<uint32_t> &order) -> void
+{
+    for (uint32_t position = 0; position < order.size(); ++position)
+    {
+        for (const auto resource : m_passes[order[position]].transients)
+        {
+            auto &r = m_resources[resource];
+            r.firstUse = std::min(r.firstUse, position);
+            r.lastUse = std::max(r.lastUse, position);
+        }
+    }
+
+    std::vector<uint32_t> transients;
+    for (uint32_t resource = 0; resource < m_resources.size(); ++resource)
+    {
+        if (not m_resources[resource].imported and m_resources[resource].firstUse != UINT32_MAX)
+        {
+            transients.push_back(resource);
+        }
+    }
+    std::ranges::sort(transients, {}, [&](uint32_t resource) { return m_resources[resource].firstUse; });
+
+    for (auto &pooled : m_pool)
+    {
+        pooled.busyUntil = UINT32_MAX;
+    }
+    for (const auto resource : transients)
+    {
+        auto &r = m_resources[resource];
+        // A pooled texture is free once its last transient's final pass came
+        // before this one's first; the passes share one encoder, so WebGPU
+        // orders the accesses
+        auto it = std::ranges::find_if(m_pool, [&](const PooledTexture &pooled) {
+            return pooled.desc == r.desc and (pooled.busyUntil == UINT32_MAX or pooled.busyUntil < r.firstUse);
+        });
+        if (it == m_pool.end())
+        {
+            const wgpu::TextureDescriptor desc{
+                .label = "RenderGraphTransient",
+                .usage = r.desc.usage,
+                .dimension = wgpu::TextureDimension::e2D,
+                .size = {r.desc.width, r.desc.height, 1},
+                .format = r.desc.format,
+            };
+            auto texture = m_device.CreateTexture(&desc);
+            auto view = texture.CreateView();
+            m_pool.push_back({.desc = r.desc, .texture = std::move(texture), .view = std::move(view)});
+            it = std::prev(m_pool.end());
+            ++m_stats.texturesCreated;
+        }
+        if (it->busyUntil == UINT32_MAX)
+        {
+            ++m_stats.physicalTextures;
+        }
+        it->busyUntil = r.lastUse;
+        it->lastFrame = m_frame;
+        r.texture = it->texture;
+        r.view = it->view;
+    }
+    m_stats.transientTextures = static_cast<uint32_t>(transients.size());
+}
+
+auto RenderGraph::Execute(wgpu::CommandEncoder &encoder) -> void
+{
+    m_stats = {};
+    const auto order = schedule();
+    allocateTransients(order);
+
+    const Resources resources(*this);
+    for (const auto pass : order)
+    {
+        auto &p = m_passes[pass];
+        if (not p.execute)
+        {
+            continue;
+        }
+        encoder.PushDebugGroup(p.name.c_str());
+        p.execute(resources, encoder);
+        encoder.PopDebugGroup();
+    }
+
+    m_passes.clear();
+    m_resources.clear();
+    m_imported_textures.clear();
+    m_imported_buffers.clear();
+}
+
+auto RenderGraph::EndFrame() -> void
+{
+    ++m_frame;
+    std::erase_if(m_pool, [&](const PooledTexture &pooled) { return pooled.lastFrame + EVICT_AFTER_FRAMES < m_frame; });
+}
+} // namespace wglib
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib
+{
+// A version of a texture in a RenderGraph. Every write returns the next
+// version; passes that read a version run after the pass that wrote it.
+struct RenderGraphTexture
+{
+    uint32_t index{UINT32_MAX};
+    uint32_t version{0};
+
+    explicit operator bool() const
+    {
+        return index != UINT32_MAX;
+    }
+};
+
+// A version of an imported buffer, see RenderGraphTexture
+struct RenderGraphBuffer
+{
+    uint32_t index{UINT32_MAX};
+    uint32_t version{0};
+
+    explicit operator bool() const
+    {
+        return index != UINT32_MAX;
+    }
+};
+
+// Transient textures with equal descriptors may share one texture
+struct TransientTextureDesc
+{
+    uint32_t width;
+    uint32_t height;
+    wgpu::TextureFormat format;
+    wgpu::TextureUsage usage{wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding};
+
+    auto operator==(const TransientTextureDesc &) const -> bool = default;
+};
+
+struct RenderGraphStats
+{
+    uint32_t passes{0};
+    // Passes dropped because nothing used what they wrote
+    uint32_t culledPasses{0};
+    uint32_t transientTextures{0};
+    // Pooled textures backing them; fewer than transientTextures when
+    // lifetimes did not overlap
+    uint32_t physicalTextures{0};
+    // Pooled textures created by this execution
+    uint32_t texturesCreated{0};
+};
+
+// Passes declare the textures and buffers they read and write; Execute orders
+// them by those dependencies, drops passes whose results are unused and records
+// the rest into one command encoder. Independent passes keep the order they
+// were added in.
+//
+// Imported resources (the surface, textures owned by layers) outlive the graph,
+// and passes writing them are always kept. Transient textures exist from the
+// first to the last pass using them and are taken from a pool kept across
+// executions: two transients whose lifetimes do not overlap share one texture.
+// Their contents are undefined when the first pass starts, so it must clear or
+// overwrite them.
+//
+// The graph is rebuilt for every submission and cleared by Execute. Only used
+// from the thread driving the engine.
+class RenderGraph
+{
+  public:
+    constexpr static uint64_t EVICT_AFTER_FRAMES = 16;
+
+    class Resources;
+    using ExecuteFn = std::function<void(const Resources &, wgpu::CommandEncoder &)>;
+
+    // Handed to the setup of AddPass to declare the pass's resources
+    class PassBuilder
+    {
+        friend RenderGraph;
+
+        RenderGraph &m_graph;
+        uint32_t m_pass;
+
+        PassBuilder(RenderGraph &graph, uint32_t pass) : m_graph(graph), m_pass(pass)
+        {
+        }
+
+      public:
+        // A transient texture written by this pass
+        auto Create(std::string_view name, const TransientTextureDesc &desc) -> RenderGraphTexture;
+
+        // See RenderGraph::ImportTexture and ImportBuffer
+        auto Import(std::string_view name, const wgpu::Texture &texture) -> RenderGraphTexture;
+        auto Import(std::string_view name, const wgpu::Buffer &buffer) -> RenderGraphBuffer;
+
+        auto Read(RenderGraphTexture texture) -> RenderGraphTexture;
+        auto Read(RenderGraphBuffer buffer) -> RenderGraphBuffer;
+
+        // Returns the version the pass produces. Only the latest version of a
+        // resource can be written.
+        auto Write(RenderGraphTexture texture) -> RenderGraphTexture;
+        auto Write(RenderGraphBuffer buffer) -> RenderGraphBuffer;
+
+        // Keeps the pass even when nothing uses what it writes
+        auto SideEffect() -> void;
+    };
+
+    // Resolves handles while the passes are recorded
+    class Resources
+    {
+        friend RenderGraph;
+
+        const RenderGraph &m_graph;
+
+        explicit Resources(const RenderGraph &graph) : m_graph(graph)
+        {
+        }
+
+      public:
+        auto Texture(RenderGraphTexture texture) const -> const wgpu::Texture &;
+        auto View(RenderGraphTexture texture) const -> const wgpu::TextureView &;
+        auto Buffer(RenderGraphBuffer buffer) const -> const wgpu::Buffer &;
+    };
+
+  private:
+    constexpr static uint32_t NO_PASS = UINT32_MAX;
+
+    struct Version
+    {
+        uint32_t producer{NO_PASS};
+        std::vector<uint32_t> readers;
+    };
+
+    struct Resource
+    {
+        std::string name;
+        bool imported;
+        std::vector<Version> versions;
+        wgpu::Texture texture;
+        wgpu::TextureView view;
+        wgpu::Buffer buffer;
+        // Transient textures only
+        TransientTextureDesc desc{};
+        // Positions in the execution order
+        uint32_t firstUse{UINT32_MAX};
+        uint32_t lastUse{0};
+    };
+
+    struct Pass
+    {
+        std::string name;
+        ExecuteFn execute;
+        // Passes producing what this one reads or overwrites
+        std::vector<uint32_t> dependencies;
+        // Passes reading versions this one overwrites; ordering only
+        std::vector<uint32_t> after;
+        // Transient resources this pass uses
+        std::vector<uint32_t> transients;
+        bool sideEffect{false};
+        bool writesImported{false};
+    };
+
+    struct PooledTexture
+    {
+        TransientTextureDesc desc;
+        wgpu::Texture texture;
+        wgpu::TextureView view;
+        uint64_t lastFrame{0};
+        // Last use of its current transient in this execution, or UINT32_MAX
+        uint32_t busyUntil{UINT32_MAX};
+    };
+
+    wgpu::Device m_device;
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+    std::unordered_map<WGPUTexture, uint32_t> m_imported_textures;
+    std::unordered_map<WGPUBuffer, uint32_t> m_imported_buffers;
+    std::vector<PooledTexture> m_pool;
+    uint64_t m_frame{0};
+    RenderGraphStats m_stats{};
+
+    auto read(uint32_t pass, uint32_t resource, uint32_t version) -> void;
+    auto write(uint32_t pass, uint32_t resource, uint32_t version) -> uint32_t;
+    auto createTransient(uint32_t pass, std::string_view name, const TransientTextureDesc &desc) -> uint32_t;
+
+    // Passes in execution order, culled passes left out
+    auto schedule() -> std::vector<uint32_t>;
+    auto allocateTransients(const std::vector<uint32_t> &order) -> void;
+
+  public:
+    explicit RenderGraph(wgpu::Device device);
+
+    // The setup declares the pass's resources and returns the function that
+    // records it. It runs immediately; the returned function runs in Execute.
+    template <typename Setup> auto AddPass(std::string_view name, Setup &&setup) -> void
+    {
+        const auto pass = static_cast<uint32_t>(m_passes.size());
+        m_passes.push_back({.name = std::string(name)});
+        PassBuilder builder(*this, pass);
+        // The setup may not add passes, but may grow m_passes' storage
+        ExecuteFn execute = std::forward<Setup>(setup)(builder);
+        m_passes[pass].execute = std::move(execute);
+    }
+
+    // Importing the same texture again in one graph returns its latest version
+    auto ImportTexture(std::string_view name, const wgpu::Texture &texture, const wgpu::TextureView &view = {})
+        -> RenderGraphTexture;
+
+    auto ImportBuffer(std::string_view name, const wgpu::Buffer &buffer) -> RenderGraphBuffer;
+
+    auto Empty() const -> bool
+    {
+        return m_passes.empty();
+    }
+
+    // Orders, culls and records the passes, then clears the graph. The caller
+    // finishes and submits the encoder.
+    auto Execute(wgpu::CommandEncoder &encoder) -> void;
+
+    // Drops pooled textures unused for EVICT_AFTER_FRAMES frames
+    auto EndFrame() -> void;
+
+    // Counters of the last execution
+    auto Stats() const -> const RenderGraphStats &
+    {
+        return m_stats;
+    }
+};
+} // namespace wglib
@@ -0,0 +1,113 @@
+#include "Scene.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace wglib
+{
+auto Scene::add(std::shared_ptr<const render_layers::RenderLayer> layer, int32_t order) -> Id
+{
+    Id id;
+    if (not m_free_ids.empty())
+    {
+        id = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+    else
+    {
+        id = static_cast<Id>(m_index_of_id.size());
+        m_index_of_id.push_back(INVALID_INDEX);
+    }
+
+    m_index_of_id[id] = static_cast<uint32_t>(m_entries.size());
+    m_entries.push_back(
+        {.layer = std::move(layer), .id = id, .order = order, .sequence = m_next_sequence++, .visible = true});
+    m_draw_list_dirty = true;
+    return id;
+}
+
+auto Scene::entry(Id id) -> Entry &
+{
+    assert(Contains(id) && "Unknown scene id");
+    return m_entries[m_index_of_id[id]];
+}
+
+auto Scene::Remove(Id id) -> void
+{
+    assert(Contains(id) && "Unknown scene id");
+    const auto index = m_index_of_id[id];
+
+    // Entry order does not matter, the draw list is sorted on rebuild
+    if (index + 1 != m_entries.size())
+    {
+        m_entries[index] = std::move(m_entries.back());
+        m_index_of_id[m_entries[index].id] = index;
+    }
+    m_entries.pop_back();
+    m_index_of_id[id] = INVALID_INDEX;
+    m_free_ids.push_back(id);
+    m_draw_list_dirty = true;
+}
+
+auto Scene::SetVisible(Id id, bool visible) -> void
+{
+    auto &e = entry(id);
+    if (e.visible != visible)
+    {
+        e.visible = visible;
+        m_draw_list_dirty = true;
+    }
+}
+
+auto Scene::SetOrder(Id id, int32_t order) -> void
+{
+    auto &e = entry(id);
+    if (e.order != order)
+    {
+        e.order = order;
+        m_draw_list_dirty = true;
+    }
+}
+
+auto Scene::Contains(Id id) const -> bool
+{
+    return id < m_index_of_id.size() and m_index_of_id[id] != INVALID_INDEX;
+}
+
+auto Scene::Clear() -> void
+{
+    m_entries.clear();
+    m_index_of_id.clear();
+    m_free_ids.clear();
+    m_draw_list.clear();
+    m_draw_list_dirty = false;
+}
+
+auto Scene::DrawList() -> std::span<const RenderQueueEntry>
+{
+    if (m_draw_list_dirty)
+    {
+        std::vector<std::pair<RenderQueueEntry, uint64_t>> visible;
+        visible.reserve(m_entries.size());
+        for (const auto &e : m_entries)
+        {
+            if (e.visible)
+            {
+                const auto key = render_layers::MakeSortKey(e.order, e.layer->GetDrawState());
+                visible.push_back({{key, e.layer.get()}, e.sequence});
+            }
+        }
+        std::ranges::sort(visible, [](const auto &a, const auto &b) {
+            return a.first.key != b.first.key ? a.first.key < b.first.key : a.second < b.second;
+        });
+
+        m_draw_list.clear();
+        for (const auto &[entry, sequence] : visible)
+        {
+            m_draw_list.push_back(entry);
+        }
+        m_draw_list_dirty = false;
+    }
+    return m_draw_list;
+}
+} // namespace wglib
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "CoreRenderer.hpp"
+#include "render_layer/RenderLayer.hpp"
+
+namespace wglib
+{
+// Retained set of layers drawn every frame without being pushed through
+// Engine::Draw. The scene holds one reference per layer and keeps a draw list
+// sorted by render queue key (order, then pipeline, bind group and buffer),
+// then insertion. The list is rebuilt only when membership, order or
+// visibility change; a layer whose pipeline or buffers change later keeps its
+// old position within its order until the next rebuild.
+class Scene
+{
+  public:
+    using Id = uint32_t;
+
+  private:
+    constexpr static uint32_t INVALID_INDEX = UINT32_MAX;
+
+    struct Entry
+    {
+        std::shared_ptr<const render_layers::RenderLayer> layer;
+        Id id;
+        int32_t order;
+        // Insertion sequence, keeps equal orders stable
+        uint64_t sequence;
+        bool visible;
+    };
+
+    std::vector<Entry> m_entries;
+    // Id -> index into m_entries
+    std::vector<uint32_t> m_index_of_id;
+    std::vector<Id> m_free_ids;
+    uint64_t m_next_sequence{0};
+
+    std::vector<RenderQueueEntry> m_draw_list;
+    bool m_draw_list_dirty{false};
+
+    auto add(std::shared_ptr<const render_layers::RenderLayer> layer, int32_t order) -> Id;
+    auto entry(Id id) -> Entry &;
+
+  public:
+    // Lower orders are drawn first. Layers of equal order may be reordered to
+    // share GPU state, give overlapping layers distinct orders.
+    template <RenderableLayer Layer> auto Add(const Renderer::Ref<Layer> &layer, int32_t order = 0) -> Id
+    {
+        return add(layer.getLayer(), order);
+    }
+
+    auto Remove(Id id) -> void;
+
+    auto SetVisible(Id id, bool visible) -> void;
+
+    auto SetOrder(Id id, int32_t order) -> void;
+
+    auto Contains(Id id) const -> bool;
+
+    auto Size() const -> size_t
+    {
+        return m_entries.size();
+    }
+
+    auto Clear() -> void;
+
+    // Visible layers in draw order, valid until the scene changes
+    auto DrawList() -> std::span<const RenderQueueEntry>;
+};
+} // namespace wglib
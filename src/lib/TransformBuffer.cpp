@@ -0,0 +1,147 @@
+#include "TransformBuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+
+namespace wglib
+{
+namespace
+{
+auto registry() -> std::unordered_map<WGPUDevice, std::shared_ptr<TransformBuffer>> &
+{
+    static std::unordered_map<WGPUDevice, std::shared_ptr<TransformBuffer>> buffers;
+    return buffers;
+}
+} // namespace
+
+auto ObjectTransform::Compose(glm::vec2 translation, float rotation, glm::vec2 scale) -> ObjectTransform
+{
+    const auto c = std::cos(rotation);
+    const auto s = std::sin(rotation);
+    return {
+        .basisX = glm::vec2{c, s} * scale.x,
+        .basisY = glm::vec2{-s, c} * scale.y,
+        .translation = translation,
+    };
+}
+
+TransformHandle::TransformHandle(TransformHandle &&other) noexcept
+    : m_owner(std::move(other.m_owner)), m_index(other.m_index)
+{
+    other.m_index = TransformBuffer::IDENTITY;
+}
+
+auto TransformHandle::operator=(TransformHandle &&other) noexcept -> TransformHandle &
+{
+    if (this != &other)
+    {
+        Reset();
+        m_owner = std::move(other.m_owner);
+        m_index = other.m_index;
+        other.m_index = TransformBuffer::IDENTITY;
+    }
+    return *this;
+}
+
+TransformHandle::~TransformHandle()
+{
+    Reset();
+}
+
+auto TransformHandle::Reset() -> void
+{
+    if (m_owner)
+    {
+        m_owner->release(m_index);
+    }
+    m_owner.reset();
+    m_index = TransformBuffer::IDENTITY;
+}
+
+auto TransformHandle::Set(const ObjectTransform &transform) -> void
+{
+    assert(m_owner && "Transform handle is empty");
+    m_owner->set(m_index, transform);
+}
+
+TransformBuffer::TransformBuffer(wgpu::Device device) : m_device(std::move(device))
+{
+    m_transforms.reserve(INITIAL_CAPACITY);
+    m_transforms.push_back({});
+    m_buffer = BufferPool::Get(m_device).Allocate(sizeof(ObjectTransform) * INITIAL_CAPACITY);
+    m_dirty_begin = 0;
+    m_dirty_end = 1;
+}
+
+auto TransformBuffer::Get(const wgpu::Device &device) -> TransformBuffer &
+{
+    auto &buffer = registry()[device.Get()];
+    if (not buffer)
+    {
+        buffer = std::make_shared<TransformBuffer>(device);
+    }
+    return *buffer;
+}
+
+auto TransformBuffer::Release(const wgpu::Device &device) -> void
+{
+    registry().erase(device.Get());
+}
+
+auto TransformBuffer::Allocate(const ObjectTransform &transform) -> TransformHandle
+{
+    TransformHandle handle;
+    handle.m_owner = shared_from_this();
+    if (not m_free_slots.empty())
+    {
+        handle.m_index = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+    else
+    {
+        handle.m_index = static_cast<uint32_t>(m_transforms.size());
+        m_transforms.emplace_back();
+    }
+    set(handle.m_index, transform);
+    return handle;
+}
+
+auto TransformBuffer::set(uint32_t index, const ObjectTransform &transform) -> void
+{
+    m_transforms[index] = transform;
+    m_dirty_begin = std::min(m_dirty_begin, index);
+    m_dirty_end = std::max(m_dirty_end, index + 1);
+}
+
+auto TransformBuffer::release(uint32_t index) -> void
+{
+    // Reusing the slot right away is safe: the next owner's write is copied
+    // after the render passes of earlier frames on the queue
+    m_free_slots.push_back(index);
+}
+
+auto TransformBuffer::Upload(UploadBelt &uploads) -> bool
+{
+    const auto required = sizeof(ObjectTransform) * m_transforms.size();
+    const auto grown = m_buffer.Size() < required;
+    if (grown)
+    {
+        // The old block is reused once the frames still reading it completed
+        m_buffer = BufferPool::Get(m_device).Allocate(std::bit_ceil(required));
+        m_dirty_begin = 0;
+        m_dirty_end = static_cast<uint32_t>(m_transforms.size());
+    }
+
+    if (m_dirty_begin < m_dirty_end)
+    {
+        uploads.Write(m_buffer.Buffer(), m_buffer.Offset() + sizeof(ObjectTransform) * m_dirty_begin,
+                      m_transforms.data() + m_dirty_begin, sizeof(ObjectTransform) * (m_dirty_end - m_dirty_begin));
+        m_dirty_begin = UINT32_MAX;
+        m_dirty_end = 0;
+    }
+    return grown;
+}
+} // namespace wglib
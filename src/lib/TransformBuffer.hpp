@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "BufferPool.hpp"
+#include "UploadBelt.hpp"
+#include "glm/ext/vector_float2.hpp"
+#include "render_layer/VertexLayout.hpp"
+
+namespace wglib
+{
+class TransformBuffer;
+
+// Model transform of one object as read by default.wgsl: a 2D affine map
+// position = basisX * local.x + basisY * local.y + translation, and a tint
+// the vertex colors are multiplied with
+struct ObjectTransform
+{
+    glm::vec2 basisX{1.0f, 0.0f};
+    glm::vec2 basisY{0.0f, 1.0f};
+    glm::vec2 translation{0.0f, 0.0f};
+    render_layers::Unorm8x4 tint{glm::vec4{1.0f}};
+    uint32_t padding{0};
+
+    // Scales, then rotates by radians (clockwise on screen, y points down),
+    // then translates
+    static auto Compose(glm::vec2 translation, float rotation = 0.0f, glm::vec2 scale = glm::vec2{1.0f})
+        -> ObjectTransform;
+};
+static_assert(sizeof(ObjectTransform) == 32);
+
+// A slot of the TransformBuffer. Returned to the buffer when reset,
+// reassigned or destroyed. An empty handle refers to the identity slot.
+class TransformHandle
+{
+    friend TransformBuffer;
+
+    std::shared_ptr<TransformBuffer> m_owner;
+    uint32_t m_index{0};
+
+  public:
+    TransformHandle() = default;
+    TransformHandle(const TransformHandle &) = delete;
+    auto operator=(const TransformHandle &) -> TransformHandle & = delete;
+    TransformHandle(TransformHandle &&other) noexcept;
+    auto operator=(TransformHandle &&other) noexcept -> TransformHandle &;
+    ~TransformHandle();
+
+    auto Reset() -> void;
+
+    // Writes the transform; it reaches the GPU with the next frame's uploads
+    auto Set(const ObjectTransform &transform) -> void;
+
+    // Index into the shader's transforms array, passed as the instance index
+    auto Index() const -> uint32_t
+    {
+        return m_index;
+    }
+
+    explicit operator bool() const
+    {
+        return m_owner != nullptr;
+    }
+};
+
+// Device-level storage buffer of per-object transforms, bound by the renderer
+// at group 0, binding 1. Meshes stay in local space and the vertex shader
+// applies the transform of their object, so moving, rotating or scaling an
+// object rewrites its 32-byte slot instead of its vertices. Slot 0 always
+// holds the identity. Changed slots are staged through the UploadBelt once
+// per frame; the CPU copy is kept so the buffer can grow.
+class TransformBuffer : public std::enable_shared_from_this<TransformBuffer>
+{
+  public:
+    constexpr static uint32_t IDENTITY = 0;
+    constexpr static uint32_t INITIAL_CAPACITY = 1024;
+
+  private:
+    friend TransformHandle;
+
+    wgpu::Device m_device;
+    std::vector<ObjectTransform> m_transforms;
+    std::vector<uint32_t> m_free_slots;
+    BufferAllocation m_buffer;
+    // Slots [begin, end) changed since the last upload
+    uint32_t m_dirty_begin{UINT32_MAX};
+    uint32_t m_dirty_end{0};
+
+    auto set(uint32_t index, const ObjectTransform &transform) -> void;
+    auto release(uint32_t index) -> void;
+
+  public:
+    explicit TransformBuffer(wgpu::Device device);
+
+    // One buffer per device, created on first use
+    static auto Get(const wgpu::Device &device) -> TransformBuffer &;
+
+    // Drops the device's buffer; handles still held keep it alive
+    static auto Release(const wgpu::Device &device) -> void;
+
+    auto Allocate(const ObjectTransform &transform = {}) -> TransformHandle;
+
+    // Stages the changed slots. Returns true when the buffer had to grow and
+    // was replaced, so bind groups referencing Binding() must be recreated.
+    auto Upload(UploadBelt &uploads) -> bool;
+
+    auto Binding() const -> const BufferAllocation &
+    {
+        return m_buffer;
+    }
+
+    // Slots in use, including the identity
+    auto Size() const -> uint32_t
+    {
+        return static_cast<uint32_t>(m_transforms.size() - m_free_slots.size());
+    }
+};
+} // namespace wglib
@@ -0,0 +1,159 @@
+#include "UploadBelt.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+
+#include "CoreUtil.hpp"
+
+namespace wglib
+{
+UploadBelt::UploadBelt(const wgpu::Instance &instance, const wgpu::Device &device)
+    : m_instance(instance), m_device(device)
+{
+}
+
+auto UploadBelt::createChunk(uint64_t size) const -> Chunk
+{
+    const wgpu::BufferDescriptor descriptor{
+        .usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc,
+        .size = std::max(MIN_CHUNK_SIZE, std::bit_ceil(size)),
+        .mappedAtCreation = true,
+    };
+    auto buffer = m_device.CreateBuffer(&descriptor);
+    auto *mapped = static_cast<uint8_t *>(buffer.GetMappedRange());
+    return {.buffer = std::move(buffer), .mapped = mapped};
+}
+
+auto UploadBelt::Begin(uint32_t frameIndex) -> void
+{
+    m_frame_index = frameIndex;
+    m_stats = {};
+    m_copies.clear();
+    m_overflow.clear();
+
+    auto &slot = m_slots[frameIndex];
+    if (slot.pendingMap)
+    {
+        // The slot's frame has completed, so this returns right away. On the
+        // web the map is polled instead and the frame stages into overflow
+        // chunks until it lands.
+#ifndef __EMSCRIPTEN__
+        if (m_instance.WaitAny(*slot.pendingMap, UINT64_MAX) != wgpu::WaitStatus::Success)
+        {
+            util::log("Failed to wait for upload buffer map");
+        }
+#endif
+        if (slot.chunk.buffer.GetMapState() == wgpu::BufferMapState::Mapped)
+        {
+            slot.chunk.mapped = static_cast<uint8_t *>(slot.chunk.buffer.GetMappedRange());
+            slot.pendingMap.reset();
+        }
+    }
+
+    // Grow to what the slot staged last time; a buffer still being mapped is
+    // kept until the map completes
+    if (not slot.pendingMap and (not slot.chunk.buffer or slot.chunk.buffer.GetSize() < slot.lastUsed))
+    {
+        slot.chunk = createChunk(slot.lastUsed);
+    }
+    slot.chunk.head = 0;
+}
+
+auto UploadBelt::reserve(uint64_t size) -> Chunk &
+{
+    const auto fits = [size](const Chunk &chunk) {
+        return chunk.mapped and chunk.head + size <= chunk.buffer.GetSize();
+    };
+
+    if (auto &chunk = m_slots[m_frame_index].chunk; fits(chunk))
+    {
+        return chunk;
+    }
+    if (not m_overflow.empty() and fits(m_overflow.back()))
+    {
+        return m_overflow.back();
+    }
+    ++m_stats.overflowChunks;
+    return m_overflow.emplace_back(createChunk(size));
+}
+
+auto UploadBelt::Write(const wgpu::Buffer &dst, uint64_t dstOffset, const void *data, uint64_t size) -> void
+{
+    assert(size % COPY_ALIGNMENT == 0 and dstOffset % COPY_ALIGNMENT == 0 && "Unaligned upload");
+    if (size == 0)
+    {
+        return;
+    }
+
+    auto &chunk = reserve(size);
+    std::memcpy(chunk.mapped + chunk.head, data, size);
+    m_copies.push_back({
+        .source = chunk.buffer,
+        .sourceOffset = chunk.head,
+        .destination = dst,
+        .destinationOffset = dstOffset,
+        .size = size,
+    });
+    chunk.head += size;
+
+    m_stats.bytes += size;
+    ++m_stats.copies;
+}
+
+auto UploadBelt::Flush(const wgpu::CommandEncoder &encoder) -> void
+{
+    auto &slot = m_slots[m_frame_index];
+    slot.lastUsed = m_stats.bytes;
+    if (m_copies.empty())
+    {
+        // Nothing staged, the buffer stays mapped for the slot's next frame
+        return;
+    }
+
+    // Staging buffers must be unmapped before the copies are submitted
+    if (slot.chunk.mapped and slot.chunk.head > 0)
+    {
+        slot.chunk.buffer.Unmap();
+        slot.chunk.mapped = nullptr;
+    }
+    for (auto &chunk : m_overflow)
+    {
+        chunk.buffer.Unmap();
+    }
+
+    for (const auto &copy : m_copies)
+    {
+        encoder.CopyBufferToBuffer(copy.source, copy.sourceOffset, copy.destination, copy.destinationOffset,
+                                   copy.size);
+    }
+    // The command buffer keeps the transient chunks alive until it completes
+    m_copies.clear();
+    m_overflow.clear();
+}
+
+auto UploadBelt::EndFrame() -> void
+{
+    auto &slot = m_slots[m_frame_index];
+    if (not slot.chunk.buffer or slot.chunk.mapped or slot.pendingMap)
+    {
+        return;
+    }
+
+#ifndef __EMSCRIPTEN__
+    constexpr auto callbackMode = wgpu::CallbackMode::WaitAnyOnly;
+#else
+    constexpr auto callbackMode = wgpu::CallbackMode::AllowSpontaneous;
+#endif
+    // Resolves once the copies reading the buffer have executed
+    slot.pendingMap = slot.chunk.buffer.MapAsync(
+        wgpu::MapMode::Write, 0, slot.chunk.buffer.GetSize(), callbackMode,
+        [](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+            if (status != wgpu::MapAsyncStatus::Success)
+            {
+                util::log("Failed to map upload buffer: {}", message.data);
+            }
+        });
+}
+} // namespace wglib
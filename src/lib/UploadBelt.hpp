@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include <webgpu/webgpu_cpp.h>
+
+#include "FramePacer.hpp"
+
+namespace wglib
+{
+struct UploadStats
+{
+    uint64_t bytes{0};
+    uint32_t copies{0};
+    // Transient staging buffers created because the slot's buffer was full or
+    // still being mapped
+    uint32_t overflowChunks{0};
+};
+
+// Per-frame linear upload allocator. Writes are copied into a mapped staging
+// buffer owned by the frame slot with a bump pointer and recorded as
+// CopyBufferToBuffer commands, which Flush encodes ahead of the frame's render
+// pass. After the submit the staging buffer is mapped again; the slot is not
+// reused before its frame completed (see FramePacer), so the map is ready by
+// then. Writes that do not fit go to a transient staging buffer, and the slot's
+// buffer grows to the frame's total on its next use.
+class UploadBelt
+{
+  public:
+    constexpr static uint64_t MIN_CHUNK_SIZE = 256 * 1024;
+    // Offset and size alignment of CopyBufferToBuffer
+    constexpr static uint64_t COPY_ALIGNMENT = 4;
+
+  private:
+    struct Chunk
+    {
+        wgpu::Buffer buffer;
+        uint8_t *mapped{nullptr};
+        uint64_t head{0};
+    };
+
+    struct Slot
+    {
+        Chunk chunk;
+        std::optional<wgpu::Future> pendingMap;
+        // Bytes staged the last time the slot was used
+        uint64_t lastUsed{0};
+    };
+
+    struct Copy
+    {
+        wgpu::Buffer source;
+        uint64_t sourceOffset;
+        wgpu::Buffer destination;
+        uint64_t destinationOffset;
+        uint64_t size;
+    };
+
+    const wgpu::Instance &m_instance;
+    const wgpu::Device &m_device;
+    std::array<Slot, FramePacer::MAX_FRAMES_IN_FLIGHT> m_slots{};
+    uint32_t m_frame_index{0};
+
+    std::vector<Chunk> m_overflow;
+    std::vector<Copy> m_copies;
+    UploadStats m_stats{};
+
+    auto createChunk(uint64_t size) const -> Chunk;
+    auto reserve(uint64_t size) -> Chunk &;
+
+  public:
+    UploadBelt(const wgpu::Instance &instance, const wgpu::Device &device);
+
+    // Starts staging the writes of a frame slot
+    auto Begin(uint32_t frameIndex) -> void;
+
+    // Stages size bytes for dst at dstOffset; both must be multiples of
+    // COPY_ALIGNMENT and dst needs CopyDst usage
+    auto Write(const wgpu::Buffer &dst, uint64_t dstOffset, const void *data, uint64_t size) -> void;
+
+    template <typename T> auto Write(const wgpu::Buffer &dst, uint64_t dstOffset, std::span<const T> data) -> void
+    {
+        Write(dst, dstOffset, data.data(), data.size_bytes());
+    }
+
+    // Encodes the staged copies; call before the commands that read the
+    // destinations
+    auto Flush(const wgpu::CommandEncoder &encoder) -> void;
+
+    // Call after the submit containing the flushed copies
+    auto EndFrame() -> void;
+
+    // Counters of the current or, after EndFrame, last frame
+    auto Stats() const -> const UploadStats &
+    {
+        return m_stats;
+    }
+};
+} // namespace wglib
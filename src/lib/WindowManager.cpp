@@ -1,7 +1,9 @@
 #include "WindowManager.hpp"
 
 #include "CoreUtil.hpp"
+#include <algorithm>
 #include <iostream>
+#include <span>
 
 #ifndef __EMSCRIPTEN__
 #include "GLFW/glfw3.h"
@@ -12,9 +14,32 @@
 #endif
 
 namespace wglib {
+namespace {
+auto pickPresentMode(wgpu::PresentMode requested,
+                     std::span<const wgpu::PresentMode> supported)
+    -> wgpu::PresentMode {
+  // A mode falls back to the ones after it, which tear and skip vblank less;
+  // Fifo is always supported
+  constexpr wgpu::PresentMode order[] = {
+      wgpu::PresentMode::Immediate, wgpu::PresentMode::Mailbox,
+      wgpu::PresentMode::FifoRelaxed, wgpu::PresentMode::Fifo};
+  auto it = std::ranges::find(order, requested);
+  if (it == std::end(order)) {
+    return wgpu::PresentMode::Fifo;
+  }
+  for (; it != std::end(order); ++it) {
+    if (std::ranges::contains(supported, *it)) {
+      return *it;
+    }
+  }
+  return wgpu::PresentMode::Fifo;
+}
+} // namespace
+
 WindowManager::WindowManager(uint32_t width, uint32_t height,
                              std::string_view title, wgpu::Instance &instance,
-                             wgpu::Device &device, wgpu::Adapter &adapter)
+                             wgpu::Device &device, wgpu::Adapter &adapter,
+                             const SurfaceOptions &options)
     : m_width(width), m_height(height), m_title(title) {
 #ifndef __EMSCRIPTEN__
   if (!glfwInit()) {
@@ -28,7 +53,9 @@ WindowManager::WindowManager(uint32_t width, uint32_t height,
     util::log("Failed to create surface");
     exit(0);
   }
-  configureSurface(device, adapter);
+  glfwSetWindowUserPointer(m_window, this);
+  glfwSetFramebufferSizeCallback(m_window, onFramebufferResize);
+  configureSurface(device, adapter, options);
 #else
   // For Emscripten, we get the surface from the canvas
   wgpu::EmscriptenSurfaceSourceCanvasHTMLSelector canvasDesc{};
@@ -42,27 +69,92 @@ WindowManager::WindowManager(uint32_t width, uint32_t height,
     util::log("Failed to create surface from canvas");
     exit(0);
   }
-  configureSurface(device, adapter);
+  configureSurface(device, adapter, options);
 #endif
 }
 
 auto WindowManager::configureSurface(wgpu::Device &device,
-                                     wgpu::Adapter &adapter) -> void {
+                                     wgpu::Adapter &adapter,
+                                     const SurfaceOptions &options) -> void {
   wgpu::SurfaceCapabilities capabilities;
   m_surface.GetCapabilities(adapter, &capabilities);
-  m_format = capabilities.formats[0];
+  const std::span formats(capabilities.formats, capabilities.formatCount);
+  const std::span presentModes(capabilities.presentModes,
+                               capabilities.presentModeCount);
+
+  m_format = std::ranges::contains(formats, options.format) ? options.format
+                                                            : formats[0];
+  const auto presentMode = pickPresentMode(options.presentMode, presentModes);
 #ifndef __EMSCRIPTEN__
 
-  util::log("Using format: {}", m_format);
+  util::log("Using format: {}, present mode: {}", m_format, presentMode);
+  if (presentMode != options.presentMode) {
+    util::log("Present mode {} is not supported", options.presentMode);
+  }
 #else
   util::log("Using format (Emscripten)");
 #endif
 
-  wgpu::SurfaceConfiguration config{.device = device,
-                                    .format = m_format,
-                                    .width = m_width,
-                                    .height = m_height};
-  m_surface.Configure(&config);
+  uint32_t width = m_width, height = m_height;
+#ifndef __EMSCRIPTEN__
+  int framebufferWidth, framebufferHeight;
+  glfwGetFramebufferSize(m_window, &framebufferWidth, &framebufferHeight);
+  width = static_cast<uint32_t>(framebufferWidth);
+  height = static_cast<uint32_t>(framebufferHeight);
+#endif
+
+  m_config = {.device = device,
+              .format = m_format,
+              .width = width,
+              .height = height,
+              .presentMode = presentMode};
+  m_surface.Configure(&m_config);
+}
+
+#ifndef __EMSCRIPTEN__
+auto WindowManager::onFramebufferResize(GLFWwindow *window, int, int)
+    -> void {
+  // Called from glfwPollEvents; the surface is reconfigured before the next
+  // frame acquires a texture rather than once per event
+  auto *self = static_cast<WindowManager *>(glfwGetWindowUserPointer(window));
+  self->m_needs_configure = true;
+}
+#endif
+
+auto WindowManager::applyResize() -> bool {
+  if (not m_needs_configure) {
+    return m_config.width > 0 && m_config.height > 0;
+  }
+#ifndef __EMSCRIPTEN__
+  int width, height, framebufferWidth, framebufferHeight;
+  glfwGetWindowSize(m_window, &width, &height);
+  glfwGetFramebufferSize(m_window, &framebufferWidth, &framebufferHeight);
+  if (framebufferWidth == 0 || framebufferHeight == 0) {
+    // Minimized; configuring an empty surface is invalid
+    return false;
+  }
+  m_width = static_cast<uint32_t>(width);
+  m_height = static_cast<uint32_t>(height);
+  m_config.width = static_cast<uint32_t>(framebufferWidth);
+  m_config.height = static_cast<uint32_t>(framebufferHeight);
+#endif
+  m_needs_configure = false;
+  // Only the extent changes; format, present mode and device are kept
+  m_surface.Configure(&m_config);
+  return true;
+}
+
+auto WindowManager::markOutdated() -> void { m_needs_configure = true; }
+
+auto WindowManager::markSuboptimal() -> void {
+#ifndef __EMSCRIPTEN__
+  int framebufferWidth, framebufferHeight;
+  glfwGetFramebufferSize(m_window, &framebufferWidth, &framebufferHeight);
+  if (static_cast<uint32_t>(framebufferWidth) != m_config.width ||
+      static_cast<uint32_t>(framebufferHeight) != m_config.height) {
+    m_needs_configure = true;
+  }
+#endif
 }
 
 auto WindowManager::width() const -> uint32_t { return m_width; }
@@ -84,4 +176,8 @@ auto WindowManager::window() const -> GLFWwindow * {
 }
 
 auto WindowManager::format() const -> wgpu::TextureFormat { return m_format; }
+
+auto WindowManager::presentMode() const -> wgpu::PresentMode {
+  return m_config.presentMode;
+}
 } // namespace wglib
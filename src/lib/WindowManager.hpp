@@ -12,8 +12,24 @@ struct GLFWwindow;
 #endif
 
 namespace wglib {
+struct SurfaceOptions {
+  // Fifo waits for vblank and is always supported. FifoRelaxed tears when a
+  // frame is late, Mailbox replaces the queued frame without tearing and
+  // Immediate presents right away; both of the latter disable vsync. An
+  // unsupported mode falls back towards Fifo: Immediate, Mailbox,
+  // FifoRelaxed, Fifo.
+  // Frames queued ahead of the display are bounded by
+  // EngineOptions::framesInFlight; use 1 with Mailbox or Immediate for the
+  // lowest latency.
+  wgpu::PresentMode presentMode{wgpu::PresentMode::Fifo};
+  // Used when the surface supports it, otherwise its preferred format
+  wgpu::TextureFormat format{wgpu::TextureFormat::Undefined};
+};
+
 class WindowManager {
 private:
+  // Window size in screen coordinates; the surface matches the framebuffer,
+  // which is larger on high-DPI displays
   uint32_t m_width, m_height;
   std::string_view m_title;
 #ifndef __EMSCRIPTEN__
@@ -21,8 +37,18 @@ private:
 #endif
   wgpu::Surface m_surface;
   wgpu::TextureFormat m_format;
+  // Kept so a resize only changes the extent
+  wgpu::SurfaceConfiguration m_config;
+  // Set by the framebuffer size callback or markOutdated
+  bool m_needs_configure{false};
+
+  auto configureSurface(wgpu::Device &device, wgpu::Adapter &adapter,
+                        const SurfaceOptions &options) -> void;
 
-  auto configureSurface(wgpu::Device &device, wgpu::Adapter &adapter) -> void;
+#ifndef __EMSCRIPTEN__
+  static auto onFramebufferResize(GLFWwindow *window, int width, int height)
+      -> void;
+#endif
 
   static auto onClick(int, int, int) -> void;
   auto onMouseMove() -> void;
@@ -30,7 +56,20 @@ private:
 public:
   WindowManager(uint32_t width, uint32_t height, std::string_view title,
                 wgpu::Instance &instance, wgpu::Device &device,
-                wgpu::Adapter &adapter);
+                wgpu::Adapter &adapter, const SurfaceOptions &options = {});
+
+  // Reconfigures the surface after a framebuffer resize. Returns false while
+  // the framebuffer is empty (minimized) and nothing can be presented.
+  auto applyResize() -> bool;
+
+  // Reconfigures on the next applyResize, e.g. after the surface reported
+  // itself outdated
+  auto markOutdated() -> void;
+
+  // Reconfigures on the next applyResize if the framebuffer no longer matches
+  // the surface. A surface that stays suboptimal at the same size is kept
+  // rather than reconfigured every frame.
+  auto markSuboptimal() -> void;
 
   auto width() const -> uint32_t;
 
@@ -43,5 +82,8 @@ public:
   auto window() const -> GLFWwindow *;
 
   auto format() const -> wgpu::TextureFormat;
+
+  // The mode in use after falling back, see SurfaceOptions
+  auto presentMode() const -> wgpu::PresentMode;
 };
 } // namespace wglib
@@ -0,0 +1,68 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace wglib::compute {
+// Return type of coroutines awaiting compute results. Runs as soon as it is
+// called, up to its first co_await, and frees itself when it returns; the
+// engine and the layers it awaits must outlive it.
+struct Workflow {
+  struct promise_type {
+    auto get_return_object() -> Workflow { return {}; }
+    auto initial_suspend() noexcept -> std::suspend_never { return {}; }
+    auto final_suspend() noexcept -> std::suspend_never { return {}; }
+    auto return_void() -> void {}
+    // Resumed from a completion callback, where nothing could handle it
+    auto unhandled_exception() -> void { std::terminate(); }
+  };
+};
+
+// Result of a pushed compute layer, see Engine::Compute. The layer is pushed
+// when the awaitable is created, so layers whose awaitables are created
+// before the first co_await run in the same submission. The coroutine
+// resumes on the engine's thread from the completion callback; what it
+// pushes then runs in the next submission.
+//
+// Every awaiter is resumed exactly once, also when the submission fails:
+// the layer's result is then whatever it hands out without the GPU's work,
+// so readback results are nullopt and should be checked before use.
+template <typename T> class ComputeAwaitable {
+public:
+  // Results handed out by reference are copied, the awaitable may outlive
+  // the layer's current result
+  using ValueType = std::remove_cvref_t<T>;
+
+private:
+  struct State {
+    std::optional<ValueType> value;
+    std::coroutine_handle<> waiter;
+  };
+
+  std::shared_ptr<State> m_state = std::make_shared<State>();
+
+public:
+  // The callback to push the layer with
+  auto Completion() const {
+    return [state = m_state](T result) {
+      state->value.emplace(std::forward<T>(result));
+      if (auto waiter = std::exchange(state->waiter, nullptr)) {
+        waiter.resume();
+      }
+    };
+  }
+
+  auto await_ready() const noexcept -> bool {
+    return m_state->value.has_value();
+  }
+
+  auto await_suspend(std::coroutine_handle<> waiter) noexcept -> void {
+    m_state->waiter = waiter;
+  }
+
+  auto await_resume() -> ValueType { return std::move(*m_state->value); }
+};
+} // namespace wglib::compute
@@ -1,36 +1,112 @@
 #include "ComputeEngine.hpp"
+#include "ComputeGraph.hpp"
 #include "lib/CoreUtil.hpp"
 #include "webgpu/webgpu_cpp.h"
 #include <optional>
 
 namespace wglib::compute {
+namespace {
+// Declares the resources a ComputeGraph hands from one layer to the next, so
+// the RenderGraph orders the reading pass after the writing one
+auto readOutput(RenderGraph::PassBuilder &builder, const ComputeOutput &output)
+    -> void {
+  if (output.buffer) {
+    builder.Read(builder.Import("ComputeOutput", output.buffer));
+  }
+  if (output.texture) {
+    builder.Read(builder.Import("ComputeOutput", output.texture));
+  }
+}
+
+auto writeOutput(RenderGraph::PassBuilder &builder, const ComputeOutput &output)
+    -> void {
+  if (output.buffer) {
+    builder.Write(builder.Import("ComputeOutput", output.buffer));
+  }
+  if (output.texture) {
+    builder.Write(builder.Import("ComputeOutput", output.texture));
+  }
+}
+} // namespace
+
 ComputeEngine::ComputeEngine(wgpu::Device &device) : m_device(device) {}
 
-auto ComputeEngine::Compute() -> void {
-  auto queue = m_device.GetQueue();
+auto ComputeEngine::PushComputeGraph(ComputeGraph &graph) -> void {
+  const auto *order = graph.order();
+  if (not order) {
+    util::log("ComputeGraph has a cycle, not pushed");
+    return;
+  }
+  for (const auto index : *order) {
+    const auto &node = graph.m_nodes[index];
+    const auto sink = node.outputs.empty();
+    ComputeTask task{.layer = node.layer,
+                     .onComplete = sink ? node.onComplete : nullptr,
+                     .outputs = node.outputs,
+                     .iterations = node.iterations};
+    for (const auto &input : node.inputs) {
+      task.inputs.push_back({.slot = input.slot,
+                             .output = input.output,
+                             .producer = graph.m_nodes[input.from].layer});
+    }
+    m_computeQueue.push(std::move(task));
+  }
+}
 
+auto ComputeEngine::Compute(RenderGraph &graph) -> void {
   while (not m_computeQueue.empty()) {
     auto task = std::move(m_computeQueue.front());
 
     m_computeQueue.pop();
 
-    auto commandEncoder = m_device.CreateCommandEncoder();
-    task.layer->Compute(commandEncoder, queue);
-
-    queue.OnSubmittedWorkDone(
-        wgpu::CallbackMode::AllowProcessEvents,
-        [callback = std::move(task.onComplete),
-         keepAlive = std::move(task.layer)](wgpu::QueueWorkDoneStatus status,
-                                            wgpu::StringView error) {
-          if (status == wgpu::QueueWorkDoneStatus::Success) {
-            if (callback) {
-              callback();
-            }
-          } else {
-            util::log("Compute work failed: {}", error.data);
-          }
-        });
+    graph.AddPass("Compute", [&](RenderGraph::PassBuilder &builder) {
+      // Results are handed out through the completion callback
+      builder.SideEffect();
+      for (const auto &input : task.inputs) {
+        const auto output = input.producer->Output(input.output);
+        task.layer->SetInput(input.slot, output);
+        readOutput(builder, output);
+      }
+      task.layer->Declare(builder);
+      for (const auto output : task.outputs) {
+        writeOutput(builder, task.layer->Output(output));
+      }
+      return [layer = task.layer, iterations = task.iterations,
+              device = m_device](const RenderGraph::Resources &,
+                                 wgpu::CommandEncoder &encoder) {
+        auto queue = device.GetQueue();
+        layer->Compute(encoder, queue, iterations);
+      };
+    });
+    m_recorded.push_back(std::move(task));
   }
 }
 
+auto ComputeEngine::Submitted() -> void {
+  if (m_recorded.empty()) {
+    return;
+  }
+  for (auto &task : m_recorded) {
+    task.layer->Submitted();
+  }
+
+  // One callback for the whole submission, fanned out in recording order.
+  // Completions run even if the work failed, so every callback and awaiter
+  // is reached once; readback results are nullopt then.
+  m_device.GetQueue().OnSubmittedWorkDone(
+      wgpu::CallbackMode::AllowProcessEvents,
+      [tasks = std::move(m_recorded)](wgpu::QueueWorkDoneStatus status,
+                                      wgpu::StringView error) {
+        if (status != wgpu::QueueWorkDoneStatus::Success) {
+          util::log("Compute work failed: {}", error.data);
+        }
+        for (const auto &task : tasks) {
+          if (task.onComplete) {
+            task.onComplete();
+          }
+        }
+      });
+  m_recorded.clear();
+}
+
 } // namespace wglib::compute
@@ -1,25 +1,30 @@
 #pragma once
 
 #include "ComputeLayer.hpp"
+#include "lib/RenderGraph.hpp"
 #include "webgpu/webgpu_cpp.h"
+#include <cassert>
 #include <concepts>
 #include <functional>
 #include <memory>
 #include <queue>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace wglib {
 class Engine;
 }
 
 namespace wglib::compute {
+class ComputeGraph;
 
 class ComputeEngine {
 
 public:
   template <typename TResult> struct ComputeLayerHandle {
     friend class ComputeEngine;
+    friend class ComputeGraph;
 
   private:
     std::shared_ptr<ComputeLayer<TResult>> m_compute_layer;
@@ -29,18 +34,36 @@ public:
   };
 
 private:
+  struct TaskInput {
+    uint32_t slot;
+    uint32_t output;
+    std::shared_ptr<IComputeLayer> producer;
+  };
+
   struct ComputeTask {
     std::shared_ptr<IComputeLayer> layer;
     std::function<void()> onComplete;
+    // ComputeGraph only: the layers whose outputs this one reads
+    std::vector<TaskInput> inputs;
+    // The outputs later tasks read
+    std::vector<uint32_t> outputs;
+    // Steps recorded back to back before the result is delivered
+    uint32_t iterations{1};
   };
 
 private:
   wgpu::Device &m_device;
   std::queue<ComputeTask> m_computeQueue;
+  // Tasks added to a graph whose submit has not been reported yet
+  std::vector<ComputeTask> m_recorded;
 
   friend class wglib::Engine;
-  // Called every tick by the engine
-  auto Compute() -> void;
+  // Called every tick by the engine. Adds a pass per queued task to the
+  // graph, so every task of a tick or frame shares one encoder and submit.
+  auto Compute(RenderGraph &graph) -> void;
+  // Called after the submit of the graph passed to Compute; the tasks'
+  // completions are fanned out from a single OnSubmittedWorkDone
+  auto Submitted() -> void;
 
 public:
   ComputeEngine(wgpu::Device &m_device);
@@ -54,9 +77,13 @@ public:
     return ComputeLayerHandle<typename LayerType::ResultType>{std::move(layer)};
   }
 
+  // Runs `iterations` steps of the layer in the submission and calls
+  // onComplete once with the result of the last, also if the submission
+  // failed
   template <typename TResult, std::invocable<TResult> CB>
-  auto PushComputeLayer(ComputeLayerHandle<TResult> &handle, CB &&onComplete)
-      -> void {
+  auto PushComputeLayer(ComputeLayerHandle<TResult> &handle, CB &&onComplete,
+                        uint32_t iterations = 1) -> void {
+    assert(iterations >= 1 && "A compute task runs at least one step");
 
     auto completion = [layer = handle.m_compute_layer,
                        cb = std::move(onComplete)]() mutable {
@@ -64,9 +91,14 @@ public:
       cb(std::move(result));
     };
 
-    m_computeQueue.push(
-        ComputeTask{handle.m_compute_layer, std::move(completion)});
+    m_computeQueue.push(ComputeTask{.layer = handle.m_compute_layer,
+                                    .onComplete = std::move(completion),
+                                    .iterations = iterations});
   }
+
+  // Queues every layer of the graph, ordered so each runs after the layers
+  // it reads. Only the completions of its sinks are called.
+  auto PushComputeGraph(ComputeGraph &graph) -> void;
 };
 
 } // namespace wglib::compute
@@ -0,0 +1,63 @@
+#include "ComputeGraph.hpp"
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <queue>
+
+namespace wglib::compute {
+auto ComputeGraph::connect(uint32_t from, uint32_t output, uint32_t to,
+                           uint32_t slot) -> void {
+  assert(from < m_nodes.size() && to < m_nodes.size() &&
+         "Connecting a node of another graph");
+  assert(from != to && "A layer cannot read its own output");
+  m_nodes[to].inputs.push_back({.from = from, .slot = slot, .output = output});
+  if (auto &outputs = m_nodes[from].outputs;
+      std::ranges::find(outputs, output) == outputs.end()) {
+    outputs.push_back(output);
+  }
+  m_order.reset();
+}
+
+auto ComputeGraph::order() -> const std::vector<uint32_t> * {
+  if (m_order) {
+    return &*m_order;
+  }
+
+  // Kahn's algorithm, taking the earliest added node that is ready so
+  // independent layers keep the order they were added in
+  const auto nodeCount = Size();
+  std::vector<std::vector<uint32_t>> successors(nodeCount);
+  std::vector<uint32_t> pending(nodeCount, 0);
+  for (uint32_t node = 0; node < nodeCount; ++node) {
+    for (const auto &input : m_nodes[node].inputs) {
+      successors[input.from].push_back(node);
+      ++pending[node];
+    }
+  }
+
+  std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> ready;
+  for (uint32_t node = 0; node < nodeCount; ++node) {
+    if (pending[node] == 0) {
+      ready.push(node);
+    }
+  }
+  std::vector<uint32_t> order;
+  order.reserve(nodeCount);
+  while (not ready.empty()) {
+    const auto node = ready.top();
+    ready.pop();
+    order.push_back(node);
+    for (const auto next : successors[node]) {
+      if (--pending[next] == 0) {
+        ready.push(next);
+      }
+    }
+  }
+
+  if (order.size() != nodeCount) {
+    return nullptr;
+  }
+  m_order = std::move(order);
+  return &*m_order;
+}
+} // namespace wglib::compute
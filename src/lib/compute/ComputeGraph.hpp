@@ -0,0 +1,100 @@
+#pragma once
+#include "ComputeEngine.hpp"
+#include "ComputeLayer.hpp"
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace wglib::compute {
+// Compute layers connected into a DAG and pushed as one unit. A layer runs
+// after the layers whose outputs it reads, and the whole graph is recorded
+// into the submission of one tick or frame, so stages hand buffers and
+// textures to each other without a CPU round-trip. Only sinks, the layers no
+// other layer reads, report results.
+//
+// The graph is kept across pushes; push it again to run the pipeline again.
+class ComputeGraph {
+  friend class ComputeEngine;
+
+public:
+  template <typename TResult> struct Node {
+    uint32_t index;
+  };
+
+private:
+  struct Input {
+    uint32_t from;
+    uint32_t slot;
+    uint32_t output;
+  };
+
+  struct GraphNode {
+    std::shared_ptr<IComputeLayer> layer;
+    std::vector<Input> inputs;
+    // The outputs other layers read; a sink has none
+    std::vector<uint32_t> outputs;
+    uint32_t iterations{1};
+    std::function<void()> onComplete;
+  };
+
+  std::vector<GraphNode> m_nodes;
+  // Topological order, reset when an edge or node is added
+  std::optional<std::vector<uint32_t>> m_order;
+
+  auto connect(uint32_t from, uint32_t output, uint32_t to, uint32_t slot)
+      -> void;
+  // Nullptr when the graph has a cycle
+  auto order() -> const std::vector<uint32_t> *;
+
+public:
+  // The layer runs `iterations` steps back to back every time the graph runs;
+  // its readers get the output of the last
+  template <typename TResult>
+  auto Add(const ComputeEngine::ComputeLayerHandle<TResult> &handle,
+           uint32_t iterations = 1) -> Node<TResult> {
+    assert(iterations >= 1 && "A compute task runs at least one step");
+    m_nodes.push_back(
+        {.layer = handle.m_compute_layer, .iterations = iterations});
+    m_order.reset();
+    return {static_cast<uint32_t>(m_nodes.size() - 1)};
+  }
+
+  // `to` reads the output of `from`, handed to it at input `slot` every time
+  // the graph runs. `from` is no longer a sink.
+  template <typename TFrom, typename TTo>
+  auto Connect(Node<TFrom> from, Node<TTo> to, uint32_t slot = 0) -> void {
+    connect(from.index, 0, to.index, slot);
+  }
+
+  // Like Connect, but `to` reads output `output` of a layer that writes
+  // several, such as the values of a RadixSortLayer
+  template <typename TFrom, typename TTo>
+  auto ConnectOutput(Node<TFrom> from, uint32_t output, Node<TTo> to,
+                     uint32_t slot = 0) -> void {
+    connect(from.index, output, to.index, slot);
+  }
+
+  // Called with the sink's result once the submission running the graph has
+  // completed. Ignored while other layers read the node.
+  template <typename TResult, std::invocable<TResult> CB>
+  auto OnComplete(Node<TResult> sink, CB &&onComplete) -> void {
+    auto layer = std::static_pointer_cast<ComputeLayer<TResult>>(
+        m_nodes[sink.index].layer);
+    m_nodes[sink.index].onComplete = [layer = std::move(layer),
+                                      cb = std::forward<CB>(
+                                          onComplete)]() mutable {
+      auto result = layer->getResult();
+      cb(std::move(result));
+    };
+  }
+
+  auto Size() const -> uint32_t {
+    return static_cast<uint32_t>(m_nodes.size());
+  }
+};
+} // namespace wglib::compute
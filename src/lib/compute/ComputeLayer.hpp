@@ -1,16 +1,39 @@
 #pragma once
+#include "lib/RenderGraph.hpp"
 #include "webgpu/webgpu_cpp.h"
+#include <cstdint>
 namespace wglib::compute {
+// What a layer hands to the layers reading it in a ComputeGraph; either
+// member may be null
+struct ComputeOutput {
+  wgpu::Buffer buffer;
+  wgpu::Texture texture;
+};
+
 // Type Erased Interface for ComputeLayer
 class IComputeLayer {
 public:
   virtual ~IComputeLayer() = default;
   virtual auto Init(wgpu::Device &) -> void = 0;
-  virtual auto Compute(wgpu::CommandEncoder &, wgpu::Queue &) -> void = 0;
+  // Declares the resources Compute reads and writes in the RenderGraph
+  virtual auto Declare(RenderGraph::PassBuilder &) -> void = 0;
+  // Records the given number of steps into the encoder shared by every task
+  // of the submission; the engine finishes and submits it
+  virtual auto Compute(wgpu::CommandEncoder &, wgpu::Queue &,
+                       uint32_t iterations) -> void = 0;
+  // Called once the submission holding the recorded commands is queued
+  virtual auto Submitted() -> void = 0;
+  // What the next Compute writes for the layers connected after this one.
+  // Output 0 is the main result; layers writing several hand out the others
+  // as outputs 1 and up.
+  virtual auto Output(uint32_t output) const -> ComputeOutput = 0;
+  // Called before Declare with the output of the layer connected to the slot
+  virtual auto SetInput(uint32_t slot, const ComputeOutput &) -> void = 0;
 };
 
 template <typename T> class ComputeLayer : public IComputeLayer {
   friend class ComputeEngine;
+  friend class ComputeGraph;
 
 public:
   using ResultType = T;
@@ -18,13 +41,49 @@ public:
 private:
   virtual auto getResult() -> T final { return this->getResultImpl(); }
   virtual auto Init(wgpu::Device &d) -> void final { this->InitImpl(d); }
-  virtual auto Compute(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void final {
-    this->ComputeImpl(e, q);
+  virtual auto Declare(RenderGraph::PassBuilder &b) -> void final {
+    this->DeclareImpl(b);
+  }
+  virtual auto Compute(wgpu::CommandEncoder &e, wgpu::Queue &q,
+                       uint32_t iterations) -> void final {
+    if (iterations == 1) {
+      this->ComputeImpl(e, q);
+    } else {
+      this->ComputeIterationsImpl(e, q, iterations);
+    }
+  }
+  virtual auto Submitted() -> void final { this->SubmittedImpl(); }
+  virtual auto Output(uint32_t output) const -> ComputeOutput final {
+    return output == 0 ? this->OutputImpl() : this->AdditionalOutputImpl(output);
+  }
+  virtual auto SetInput(uint32_t slot, const ComputeOutput &input)
+      -> void final {
+    this->SetInputImpl(slot, input);
   }
 
 protected:
   virtual auto getResultImpl() -> T = 0;
   virtual auto InitImpl(wgpu::Device &) -> void = 0;
+  virtual auto DeclareImpl(RenderGraph::PassBuilder &) -> void {}
   virtual auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &) -> void = 0;
+  // Several steps back to back whose result is delivered once. Layers whose
+  // steps each hand out an output override this to only write the last one.
+  virtual auto ComputeIterationsImpl(wgpu::CommandEncoder &e, wgpu::Queue &q,
+                                     uint32_t iterations) -> void {
+    for (uint32_t i = 0; i < iterations; ++i) {
+      this->ComputeImpl(e, q);
+    }
+  }
+  // Work that needs the commands submitted, such as MapAsync of a buffer
+  // ComputeImpl copied into
+  virtual auto SubmittedImpl() -> void {}
+  // Layers feeding others in a ComputeGraph return what ComputeImpl writes
+  virtual auto OutputImpl() const -> ComputeOutput { return {}; }
+  // Outputs 1 and up, read through ComputeGraph::ConnectOutput
+  virtual auto AdditionalOutputImpl(uint32_t) const -> ComputeOutput {
+    return {};
+  }
+  // Layers reading others bind the input here; it may change between runs
+  virtual auto SetInputImpl(uint32_t, const ComputeOutput &) -> void {}
 };
 } // namespace wglib::compute
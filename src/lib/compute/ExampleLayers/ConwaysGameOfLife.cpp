@@ -1,13 +1,15 @@
 #include "ConwaysGameOfLife.hpp"
 #include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
 #include "webgpu/webgpu_cpp.h"
 #include <cstddef>
 #include <cstdlib>
 #include <utility>
 
 namespace wglib::compute {
-ConwaysGameOfLifeComputeLayer::ConwaysGameOfLifeComputeLayer(glm::vec2 size)
-    : m_size(size) {
+ConwaysGameOfLifeComputeLayer::ConwaysGameOfLifeComputeLayer(
+    glm::vec2 size, uint32_t outputCount)
+    : m_size(size), m_outputCount(outputCount) {
   // TODO remove
   util::log("Constructed ");
   m_initalData.reserve(m_size.x * m_size.y);
@@ -45,7 +47,7 @@ auto ConwaysGameOfLifeComputeLayer::InitImpl(wgpu::Device &device) -> void {
       m_uniformBuffer.Unmap();
     }
 
-    // Create texture
+    // Create the output textures
     const wgpu::TextureDescriptor texDesc{
         .label = "ConwaysGameOfLifeTexture",
         .usage = wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::CopySrc |
@@ -59,67 +61,74 @@ auto ConwaysGameOfLifeComputeLayer::InitImpl(wgpu::Device &device) -> void {
         .sampleCount = 1,
         .viewFormatCount = 0,
         .viewFormats = nullptr};
-    m_texture = device.CreateTexture(&texDesc);
-    m_textureView = m_texture.CreateView();
+    m_outputs.Init(device, texDesc, m_outputCount);
 
     // Set up pipeline and shaderModule
 
-    wgpu::ComputePipelineDescriptor desc{
-        .compute = {
-            .module = util::createShaderModuleFromFile(
-                "../src/shaders/ConwaysGameOfLife/compute.wgsl", device)}};
-    m_computePipeline = device.CreateComputePipeline(&desc);
+    m_computePipeline = PipelineCache::Get(device).GetComputePipeline(
+        {.shaderPath = "../src/shaders/ConwaysGameOfLife/compute.wgsl"});
     m_init = true;
   }
 
-  {
-    wgpu::BindGroupEntry entries[4]{
-        {.binding = 0, .buffer = m_firstBuffer},
-        {.binding = 1, .buffer = m_secondBuffer},
-        {.binding = 2, .textureView = m_textureView},
-        {.binding = 3, .buffer = m_uniformBuffer}};
-    wgpu::BindGroupDescriptor desc{.layout =
-                                       m_computePipeline.GetBindGroupLayout(0),
-                                   .entryCount = 4,
-                                   .entries = entries};
-    m_bindGroups[0] = device.CreateBindGroup(&desc);
-  }
-
-  {
-    wgpu::BindGroupEntry entries[4]{
-        {.binding = 0, .buffer = m_secondBuffer},
-        {.binding = 1, .buffer = m_firstBuffer},
-        {.binding = 2, .textureView = m_textureView},
-        {.binding = 3, .buffer = m_uniformBuffer}};
-    wgpu::BindGroupDescriptor desc{.layout =
-                                       m_computePipeline.GetBindGroupLayout(0),
-                                   .entryCount = 4,
-                                   .entries = entries};
-    m_bindGroups[1] = device.CreateBindGroup(&desc);
+  m_bindGroups.clear();
+  const wgpu::Buffer *directions[2][2]{{&m_firstBuffer, &m_secondBuffer},
+                                       {&m_secondBuffer, &m_firstBuffer}};
+  for (const auto &[input, output] : directions) {
+    for (uint32_t texture = 0; texture < m_outputs.Size(); ++texture) {
+      wgpu::BindGroupEntry entries[4]{
+          {.binding = 0, .buffer = *input},
+          {.binding = 1, .buffer = *output},
+          {.binding = 2, .textureView = m_outputs.View(texture)},
+          {.binding = 3, .buffer = m_uniformBuffer}};
+      wgpu::BindGroupDescriptor desc{
+          .layout = m_computePipeline.GetBindGroupLayout(0),
+          .entryCount = 4,
+          .entries = entries};
+      m_bindGroups.push_back(device.CreateBindGroup(&desc));
+    }
   }
 
   m_bindGroupIndex = 0;
 } // namespace wglib::compute::example_layers
 
+auto ConwaysGameOfLifeComputeLayer::DeclareImpl(
+    RenderGraph::PassBuilder &builder) -> void {
+  builder.Write(builder.Import("ConwaysGameOfLife", m_outputs.Next()));
+}
+
+auto ConwaysGameOfLifeComputeLayer::OutputImpl() const -> ComputeOutput {
+  return {.texture = m_outputs.Next()};
+}
+
 auto ConwaysGameOfLifeComputeLayer::ComputeImpl(wgpu::CommandEncoder &encoder,
                                                 wgpu::Queue &queue) -> void {
+  ComputeIterationsImpl(encoder, queue, 1);
+}
+
+auto ConwaysGameOfLifeComputeLayer::ComputeIterationsImpl(
+    wgpu::CommandEncoder &encoder, wgpu::Queue &, uint32_t iterations)
+    -> void {
 
   auto computePass = encoder.BeginComputePass();
   computePass.SetPipeline(m_computePipeline);
-  computePass.SetBindGroup(0, m_bindGroups[m_bindGroupIndex]);
-
-  computePass.DispatchWorkgroups(
-      util::divCeil(static_cast<size_t>(m_size.x), 8uz),
-      util::divCeil(static_cast<size_t>(m_size.y), 8uz));
+  for (uint32_t i = 0; i < iterations; ++i) {
+    // Dispatches in one pass are ordered, so each reads the cells the
+    // previous one wrote
+    computePass.SetBindGroup(0,
+                             m_bindGroups[m_bindGroupIndex * m_outputs.Size() +
+                                          m_outputs.NextIndex()]);
+    computePass.DispatchWorkgroups(
+        util::divCeil(static_cast<size_t>(m_size.x), 8uz),
+        util::divCeil(static_cast<size_t>(m_size.y), 8uz));
+    Swap();
+    m_bindGroupIndex ^= 1;
+  }
   computePass.End();
-  const auto commandBuffer = encoder.Finish();
-  queue.Submit(1, &commandBuffer);
-  Swap();
-  m_bindGroupIndex ^= 1;
+  m_outputs.Advance();
 }
 
 auto ConwaysGameOfLifeComputeLayer::getResultImpl() -> const wgpu::Texture & {
-  return m_texture;
+  return m_outputs.TakeCompleted();
 }
 
 auto ConwaysGameOfLifeComputeLayer::Swap() -> void {
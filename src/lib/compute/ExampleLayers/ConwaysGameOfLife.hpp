@@ -1,5 +1,6 @@
 #include "glm/ext/vector_float2.hpp"
 #include "lib/compute/ComputeLayer.hpp"
+#include "lib/compute/TextureRing.hpp"
 #include "webgpu/webgpu_cpp.h"
 #include <vector>
 namespace wglib::compute {
@@ -14,10 +15,11 @@ class ConwaysGameOfLifeComputeLayer
 private:
   glm::vec2 m_size;
   wgpu::Buffer m_firstBuffer, m_secondBuffer, m_uniformBuffer;
-  wgpu::Texture m_texture;
-  wgpu::TextureView m_textureView;
+  uint32_t m_outputCount;
+  TextureRing m_outputs;
   wgpu::Buffer *m_currBufferPointer, *m_secBufferPointer;
-  wgpu::BindGroup m_bindGroups[2];
+  // Per buffer direction, one for each output texture
+  std::vector<wgpu::BindGroup> m_bindGroups;
   uint8_t m_bindGroupIndex{0};
 
   bool m_init{false};
@@ -26,12 +28,20 @@ private:
 
 public:
   auto Swap() -> void;
-  ConwaysGameOfLifeComputeLayer(glm::vec2);
+  // With more than one output, each generation is drawn into the next texture
+  // of a ring, see TextureRing
+  ConwaysGameOfLifeComputeLayer(glm::vec2, uint32_t outputCount = 1);
 
 protected:
   auto getResultImpl() -> const wgpu::Texture & override;
   auto InitImpl(wgpu::Device &device) -> void override;
+  auto DeclareImpl(RenderGraph::PassBuilder &builder) -> void override;
+  auto OutputImpl() const -> ComputeOutput override;
   auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void override;
+  // Generations ping-pong between the cell buffers inside one compute pass;
+  // all of them draw into the same output texture, so the last one is shown
+  auto ComputeIterationsImpl(wgpu::CommandEncoder &e, wgpu::Queue &q,
+                             uint32_t iterations) -> void override;
 };
 
 } // namespace wglib::compute
@@ -1,32 +1,32 @@
 #pragma once
 #include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
 #include "lib/compute/ComputeLayer.hpp"
+#include "lib/compute/Readback.hpp"
 #include "webgpu/webgpu_cpp.h"
-#include <atomic>
+#include <optional>
 #include <ranges>
-#include <span>
 #include <vector>
 
 namespace wglib::compute {
 
 template <size_t numItems>
-class ExampleLayer
-    : public ComputeLayer<std::optional<std::span<const float, numItems>>> {
+class ExampleLayer : public ComputeLayer<std::optional<ReadbackView<float>>> {
 
   struct alignas(16) Uniforms {
     float multiplier;
   };
 
 private:
-  wgpu::Buffer m_initalBuffer, m_multiplierBuffer, m_ResultBuffer,
-      m_stagingBuffer;
+  wgpu::Buffer m_initalBuffer, m_multiplierBuffer, m_ResultBuffer;
+  // One staging buffer per push in flight, plus the one being viewed
+  ReadbackRing m_readback;
   wgpu::ComputePipeline m_computePipeline;
   wgpu::BindGroup m_bindGroup;
   uint64_t m_numItems = numItems;
   float m_multiplier;
 
   std::vector<float> m_items;
-  std::atomic<uint8_t> m_resultsReady;
 
   auto initBuffers(wgpu::Device &) -> void;
   bool init{false};
@@ -40,22 +40,20 @@ public:
   ~ExampleLayer() = default;
 
 protected:
-  auto getResultImpl()
-      -> std::optional<std::span<const float, numItems>> override {
-    if (m_resultsReady) {
-
-      auto *float_ptr =
-          static_cast<const float *>(m_stagingBuffer.GetConstMappedRange());
-
-      return std::span<const float, numItems>(float_ptr, numItems);
-
-    } else {
+  auto getResultImpl() -> std::optional<ReadbackView<float>> override {
+    auto result = m_readback.Take<float>();
+    if (not result) {
       util::log("Results not ready");
-      return std::nullopt;
     }
+    return result;
   }
   auto InitImpl(wgpu::Device &) -> void override;
   auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &) -> void override;
+  // The input is the same every step, so repeated dispatches are read back
+  // once
+  auto ComputeIterationsImpl(wgpu::CommandEncoder &e, wgpu::Queue &,
+                             uint32_t iterations) -> void override;
+  auto SubmittedImpl() -> void override;
 };
 
 template <size_t numItems> auto ExampleLayer<numItems>::initItems() -> void {
@@ -71,20 +69,15 @@ auto ExampleLayer<numItems>::initBuffers(wgpu::Device &device) -> void {
   m_ResultBuffer = util::createBuffer < float,
   wgpu::BufferUsage::Storage |
       wgpu::BufferUsage::CopySrc > (device, m_items.size());
-  m_stagingBuffer = util::createBuffer < float,
-  wgpu::BufferUsage::MapRead |
-      wgpu::BufferUsage::CopyDst > (device, m_items.size());
+  m_readback.Init(device, m_items.size() * sizeof(float), 3);
   m_multiplierBuffer = util::createBuffer < Uniforms,
   wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst > (device, 1);
 }
 
 template <size_t numItems>
 auto ExampleLayer<numItems>::initComputePipeline(wgpu::Device &device) -> void {
-  const auto shaderModule =
-      util::createShaderModuleFromFile("../src/shaders/example.wgsl", device);
-  const wgpu::ComputePipelineDescriptor desc{
-      .compute = {.module = shaderModule}};
-  m_computePipeline = device.CreateComputePipeline(&desc);
+  m_computePipeline = PipelineCache::Get(device).GetComputePipeline(
+      {.shaderPath = "../src/shaders/example.wgsl"});
 }
 
 template <size_t numItems>
@@ -112,6 +105,14 @@ auto ExampleLayer<numItems>::InitImpl(wgpu::Device &device) -> void {
 template <size_t numItems>
 auto ExampleLayer<numItems>::ComputeImpl(wgpu::CommandEncoder &e,
                                          wgpu::Queue &queue) -> void {
+  ComputeIterationsImpl(e, queue, 1);
+}
+
+template <size_t numItems>
+auto ExampleLayer<numItems>::ComputeIterationsImpl(wgpu::CommandEncoder &e,
+                                                   wgpu::Queue &queue,
+                                                   uint32_t iterations)
+    -> void {
   // Upload input data to buffer
   queue.WriteBuffer(m_initalBuffer, 0, m_items.data(),
                     m_items.size() * sizeof(float));
@@ -123,27 +124,19 @@ auto ExampleLayer<numItems>::ComputeImpl(wgpu::CommandEncoder &e,
   auto computePass = e.BeginComputePass();
   computePass.SetPipeline(m_computePipeline);
   computePass.SetBindGroup(0, m_bindGroup);
-  computePass.DispatchWorkgroups(util::divCeil(m_items.size(), 64uz));
+  for (uint32_t i = 0; i < iterations; ++i) {
+    computePass.DispatchWorkgroups(util::divCeil(m_items.size(), 64uz));
+  }
   computePass.End();
 
-  // Copy result buffer to staging buffer for CPU readback
-  e.CopyBufferToBuffer(m_ResultBuffer, 0, m_stagingBuffer, 0,
-                       m_items.size() * sizeof(float));
-
-  const auto commandBuffer = e.Finish();
-  queue.Submit(1, &commandBuffer);
-
-  m_stagingBuffer.MapAsync(
-      wgpu::MapMode::Read, 0, m_stagingBuffer.GetSize(),
-      wgpu::CallbackMode::AllowSpontaneous,
-      [&](wgpu::MapAsyncStatus status, wgpu::StringView error) {
-        if (status == wgpu::MapAsyncStatus::Success) {
-          m_resultsReady = true;
-          util::log("Done mapping buffer, ready to be read");
-        } else {
-          util::log("Failed to map result buffer: {}", error.data);
-        }
-      });
+  // Copy result buffer to a staging buffer for CPU readback
+  m_readback.Record(e, m_ResultBuffer);
+}
+
+template <size_t numItems>
+auto ExampleLayer<numItems>::SubmittedImpl() -> void {
+  // The copies into the staging buffers are queued now
+  m_readback.Submitted();
 }
 
 } // namespace wglib::compute
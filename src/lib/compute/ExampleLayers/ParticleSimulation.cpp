@@ -1,6 +1,7 @@
 #include "ParticleSimulation.hpp"
 #include "glm/ext/vector_float2.hpp"
 #include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
 #include "webgpu/webgpu_cpp.h"
 #include <atomic>
 #include <random>
@@ -12,11 +13,13 @@ namespace wglib::compute {
 ParticleSimulationLayer::ParticleSimulationLayer(
     uint32_t numBalls, glm::vec2 size, uint32_t circleRadius,
     glm::vec4 ballColor, glm::vec2 startLocation, uint32_t numPerRow, float dt,
-    float gravity, float damping, float forceAmp, float decayLength)
+    float gravity, float damping, float forceAmp, float decayLength,
+    uint32_t outputCount)
     : m_numBalls(numBalls), m_size(size), m_circleRadius(circleRadius),
       m_ballColor(ballColor), m_startLocation(startLocation),
       m_initalParticles(genParticlesInSquareFormation(
           m_numBalls, m_size, m_startLocation, numPerRow, circleRadius)),
+      m_outputCount(outputCount),
       m_uniforms{ballColor, size, dt, gravity, damping, forceAmp, decayLength} {
 
 }
@@ -84,64 +87,81 @@ auto ParticleSimulationLayer::InitImpl(wgpu::Device &device) -> void {
                static_cast<uint32_t>(m_size.y)},
       .format = wgpu::TextureFormat::RGBA8Unorm,
   };
-  m_drawTexture = device.CreateTexture(&textureDesc);
-
-  const wgpu::ComputePipelineDescriptor desc{
-      .compute = {
-          .module = util::createShaderModuleFromFile(
-              "../src/shaders/ParticleSimulation/particle.wgsl", device)}};
-  m_computePipeline = device.CreateComputePipeline(&desc);
-  wgpu::BindGroupEntry entriesSet1[4]{
-      {.binding = 0,
-       .buffer = m_circleBuffer1,
-       .size = sizeof(Particle) * m_numBalls},
-      {.binding = 1,
-       .buffer = m_circleBuffer2,
-       .size = sizeof(Particle) * m_numBalls},
-      {.binding = 2,
-       .buffer = m_circleUniformBuffer,
-       .size = sizeof(CircleUniforms)},
-      {.binding = 3, .textureView = m_drawTexture.CreateView()},
-  };
-  wgpu::BindGroupEntry entriesSet2[4]{
-      {.binding = 0,
-       .buffer = m_circleBuffer2,
-       .size = sizeof(Particle) * m_numBalls},
-      {.binding = 1,
-       .buffer = m_circleBuffer1,
-       .size = sizeof(Particle) * m_numBalls},
-      {.binding = 2,
-       .buffer = m_circleUniformBuffer,
-       .size = sizeof(CircleUniforms)},
-      {.binding = 3, .textureView = m_drawTexture.CreateView()},
-  };
-  wgpu::BindGroupDescriptor bgDesc1{.layout =
-                                        m_computePipeline.GetBindGroupLayout(0),
-                                    .entryCount = 4,
-                                    .entries = entriesSet1};
-  wgpu::BindGroupDescriptor bgDesc2{.layout =
-                                        m_computePipeline.GetBindGroupLayout(0),
-                                    .entryCount = 4,
-                                    .entries = entriesSet2};
-
-  m_bg1 = device.CreateBindGroup(&bgDesc1);
-  m_bg2 = device.CreateBindGroup(&bgDesc2);
+  m_outputs.Init(device, textureDesc, m_outputCount);
+
+  m_computePipeline = PipelineCache::Get(device).GetComputePipeline(
+      {.shaderPath = "../src/shaders/ParticleSimulation/particle.wgsl"});
+  const wgpu::Buffer *directions[2][2]{{&m_circleBuffer1, &m_circleBuffer2},
+                                       {&m_circleBuffer2, &m_circleBuffer1}};
+  for (const auto &[input, output] : directions) {
+    for (uint32_t texture = 0; texture < m_outputs.Size(); ++texture) {
+      wgpu::BindGroupEntry entries[4]{
+          {.binding = 0, .buffer = *input, .size = sizeof(Particle) * m_numBalls},
+          {.binding = 1,
+           .buffer = *output,
+           .size = sizeof(Particle) * m_numBalls},
+          {.binding = 2,
+           .buffer = m_circleUniformBuffer,
+           .size = sizeof(CircleUniforms)},
+          {.binding = 3, .textureView = m_outputs.View(texture)},
+      };
+      wgpu::BindGroupDescriptor bgDesc{
+          .layout = m_computePipeline.GetBindGroupLayout(0),
+          .entryCount = 4,
+          .entries = entries};
+      m_bindGroups.push_back(device.CreateBindGroup(&bgDesc));
+    }
+  }
 
   readyFlag.store(true, std::memory_order_release);
 }
 auto ParticleSimulationLayer::getResultImpl() -> std::optional<wgpu::Texture> {
   if (readyFlag.load(std::memory_order_acquire)) {
-    return m_drawTexture;
+    return m_outputs.TakeCompleted();
   } else {
     return std::nullopt;
   }
 }
+auto ParticleSimulationLayer::DeclareImpl(RenderGraph::PassBuilder &builder)
+    -> void {
+  // Rendering layers that sample the texture are ordered after this pass
+  builder.Write(builder.Import("ParticleSimulation", m_outputs.Next()));
+}
+
+auto ParticleSimulationLayer::OutputImpl() const -> ComputeOutput {
+  return {.texture = m_outputs.Next()};
+}
+
 auto ParticleSimulationLayer::ComputeImpl(wgpu::CommandEncoder &encoder,
                                           wgpu::Queue &queue) -> void {
+  ComputeIterationsImpl(encoder, queue, 1);
+}
+
+auto ParticleSimulationLayer::ComputeIterationsImpl(
+    wgpu::CommandEncoder &encoder, wgpu::Queue &, uint32_t iterations)
+    -> void {
+  const auto step = [&](const wgpu::ComputePassEncoder &computePass) {
+    computePass.SetBindGroup(0,
+                             m_bindGroups[m_bindGroupIndex * m_outputs.Size() +
+                                          m_outputs.NextIndex()]);
+    computePass.DispatchWorkgroups(util::divCeil<uint32_t>(m_numBalls, 64));
+    m_bindGroupIndex ^= 1;
+  };
+
+  if (iterations > 1) {
+    // Steps before the last only advance the particles; what they draw is
+    // cleared below
+    const auto computePass = encoder.BeginComputePass();
+    computePass.SetPipeline(m_computePipeline);
+    for (uint32_t i = 0; i + 1 < iterations; ++i) {
+      step(computePass);
+    }
+    computePass.End();
+  }
 
   // Clear the texture using a render pass
   wgpu::RenderPassColorAttachment colorAttachment{
-      .view = m_drawTexture.CreateView(),
+      .view = m_outputs.View(m_outputs.NextIndex()),
       .loadOp = wgpu::LoadOp::Clear,
       .storeOp = wgpu::StoreOp::Store,
       .clearValue = {0.0, 0.0, 0.0, 1.0}, // Clear to black
@@ -157,14 +177,10 @@ auto ParticleSimulationLayer::ComputeImpl(wgpu::CommandEncoder &encoder,
 
   // Run compute pass to simulate physics and draw particles
   const auto computePass = encoder.BeginComputePass();
-  computePass.SetBindGroup(0, m_bg1);
   computePass.SetPipeline(m_computePipeline);
-  computePass.DispatchWorkgroups(util::divCeil<uint32_t>(m_numBalls, 64));
+  step(computePass);
   computePass.End();
 
-  const auto commandBuffer = encoder.Finish();
-  queue.Submit(1, &commandBuffer);
-
-  std::swap(m_bg1, m_bg2);
+  m_outputs.Advance();
 }
 } // namespace wglib::compute
@@ -3,6 +3,7 @@
 
 #include "glm/vec4.hpp"
 #include "lib/compute/ComputeLayer.hpp"
+#include "lib/compute/TextureRing.hpp"
 #include "webgpu/webgpu_cpp.h"
 #include <atomic>
 namespace wglib::compute {
@@ -33,12 +34,15 @@ private:
   glm::vec2 m_startLocation;
   std::vector<Particle> m_initalParticles;
   wgpu::ComputePipeline m_computePipeline;
-  wgpu::BindGroup m_bg1, m_bg2;
+  // Per buffer direction, one for each output texture
+  std::vector<wgpu::BindGroup> m_bindGroups;
+  uint8_t m_bindGroupIndex{0};
   std::atomic<bool> readyFlag{false};
   bool m_initialized{false};
 
   wgpu::Buffer m_circleUniformBuffer, m_circleBuffer1, m_circleBuffer2;
-  wgpu::Texture m_drawTexture;
+  uint32_t m_outputCount;
+  TextureRing m_outputs;
 
   CircleUniforms m_uniforms;
 
@@ -52,11 +56,17 @@ public:
                           uint32_t circleRadius, glm::vec4 ballColor,
                           glm::vec2 startLocation, uint32_t numPerRow, float dt,
                           float gravity, float damping, float forceAmp,
-                          float decayLength);
+                          float decayLength, uint32_t outputCount = 1);
 
 protected:
   virtual auto getResultImpl() -> std::optional<wgpu::Texture>;
   virtual auto InitImpl(wgpu::Device &) -> void;
+  virtual auto DeclareImpl(RenderGraph::PassBuilder &) -> void;
+  virtual auto OutputImpl() const -> ComputeOutput;
   virtual auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &) -> void;
+  // Steps run back to back on the particle buffers; only the last one is
+  // drawn into the output texture
+  virtual auto ComputeIterationsImpl(wgpu::CommandEncoder &e, wgpu::Queue &,
+                                     uint32_t iterations) -> void;
 };
 } // namespace wglib::compute
@@ -0,0 +1,146 @@
+#pragma once
+#include "Primitives.hpp"
+#include "Scan.hpp"
+#include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
+#include "lib/compute/ComputeLayer.hpp"
+#include "webgpu/webgpu_cpp.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace wglib::compute {
+// Where Compact leaves its result: the kept values at the front of `values`,
+// and how many there are as the only element of `count`
+struct CompactBuffers {
+  wgpu::Buffer values;
+  wgpu::Buffer count;
+};
+
+// Stream compaction: keeps the values whose flag is not 0 and drops those
+// whose flag is 0, preserving their order. An exclusive scan that counts the
+// non-zero flags gives every kept value its position, and a scatter pass
+// moves it there.
+//
+// Values and flags are either uploaded once from the vectors the layer is
+// created with, or the buffers handed to input slots 0 and 1 in a
+// ComputeGraph, up to the capacity. Readers in a graph get the values buffer.
+template <PrimitiveElement T>
+class Compact : public ComputeLayer<const CompactBuffers &> {
+  ScanPasses<uint32_t> m_scan;
+  wgpu::Device m_device;
+  wgpu::ComputePipeline m_scatterPipeline;
+  wgpu::BindGroupLayout m_scatterLayout;
+  wgpu::Buffer m_params;
+  wgpu::Buffer m_values, m_flags, m_positions;
+  CompactBuffers m_result;
+  uint32_t m_capacity;
+  uint32_t m_writtenCount{UINT32_MAX};
+  // Uploaded by InitImpl when the layer is created with values
+  std::optional<std::vector<T>> m_initialValues;
+  std::vector<uint32_t> m_initialFlags;
+
+public:
+  explicit Compact(uint32_t capacity) : m_capacity(capacity) {}
+
+  Compact(std::vector<T> values, std::vector<uint32_t> flags)
+      : m_capacity(static_cast<uint32_t>(values.size())),
+        m_initialValues(std::move(values)), m_initialFlags(std::move(flags)) {
+    assert(m_initialFlags.size() == m_initialValues->size() &&
+           "Every value needs a flag");
+  }
+
+protected:
+  auto getResultImpl() -> const CompactBuffers & override { return m_result; }
+
+  auto InitImpl(wgpu::Device &device) -> void override {
+    m_device = device;
+    m_scan.Init(device, m_capacity);
+    m_scatterPipeline = PipelineCache::Get(device).GetComputePipeline(
+        {.shaderPath = "../src/shaders/Primitives/compact.wgsl",
+         .prelude = primitivePrelude<T, Sum>()});
+    m_scatterLayout = m_scatterPipeline.GetBindGroupLayout(0);
+
+    m_params = util::createBuffer < PrimitiveParams,
+    wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst > (device, 1);
+    m_positions = createPrimitiveBuffer<uint32_t>(device, m_capacity);
+    m_result = {.values = createPrimitiveBuffer<T>(device, m_capacity),
+                .count = createPrimitiveBuffer<uint32_t>(device, 1)};
+
+    if (m_initialValues) {
+      auto queue = device.GetQueue();
+      m_values = createPrimitiveBuffer<T>(device, m_capacity);
+      m_flags = createPrimitiveBuffer<uint32_t>(device, m_capacity);
+      queue.WriteBuffer(m_values, 0, m_initialValues->data(),
+                        m_initialValues->size() * sizeof(T));
+      queue.WriteBuffer(m_flags, 0, m_initialFlags.data(),
+                        m_initialFlags.size() * sizeof(uint32_t));
+      m_initialValues.reset();
+      m_initialFlags = {};
+    }
+  }
+
+  auto DeclareImpl(RenderGraph::PassBuilder &builder) -> void override {
+    if (m_values && m_flags) {
+      builder.Read(builder.Import("CompactValues", m_values));
+      builder.Read(builder.Import("CompactFlags", m_flags));
+    }
+    builder.Write(builder.Import("Compact", m_result.values));
+    builder.Write(builder.Import("CompactCount", m_result.count));
+  }
+
+  auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void override {
+    if (not m_values || not m_flags) {
+      util::log("Compact has no input");
+      return;
+    }
+    const auto count = std::min(
+        {m_capacity, static_cast<uint32_t>(m_values.GetSize() / sizeof(T)),
+         static_cast<uint32_t>(m_flags.GetSize() / sizeof(uint32_t))});
+    if (count == 0) {
+      // The scatter pass writes the count from the last element
+      e.ClearBuffer(m_result.count);
+      return;
+    }
+
+    if (count != m_writtenCount) {
+      const PrimitiveParams params{.count = count};
+      q.WriteBuffer(m_params, 0, &params, sizeof(params));
+      m_writtenCount = count;
+    }
+    m_scan.Record(e, q, m_flags, m_positions, count, ScanKind::Exclusive,
+                  ScanInput::Flags);
+
+    const wgpu::BindGroupEntry entries[]{
+        {.binding = 0, .buffer = m_params, .size = sizeof(PrimitiveParams)},
+        {.binding = 1, .buffer = m_values},
+        {.binding = 2, .buffer = m_flags},
+        {.binding = 3, .buffer = m_positions},
+        {.binding = 4, .buffer = m_result.values},
+        {.binding = 5, .buffer = m_result.count},
+    };
+    auto pass = e.BeginComputePass();
+    pass.SetPipeline(m_scatterPipeline);
+    pass.SetBindGroup(0, PipelineCache::Get(m_device).GetBindGroup(
+                             m_scatterLayout, entries));
+    pass.DispatchWorkgroups(primitiveTiles(count));
+    pass.End();
+  }
+
+  auto OutputImpl() const -> ComputeOutput override {
+    return {.buffer = m_result.values};
+  }
+
+  auto SetInputImpl(uint32_t slot, const ComputeOutput &input)
+      -> void override {
+    if (slot > 1 || not input.buffer) {
+      return;
+    }
+    // Compacts as many elements as both buffers hold
+    (slot == 0 ? m_values : m_flags) = input.buffer;
+  }
+};
+} // namespace wglib::compute
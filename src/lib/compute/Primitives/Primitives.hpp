@@ -0,0 +1,195 @@
+#pragma once
+#include "lib/CoreUtil.hpp"
+#include "webgpu/webgpu_cpp.h"
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Building blocks shared by the parallel primitives: element types and
+// operators, the tiling of their multi-level passes, and CPU references to
+// validate their results against.
+namespace wglib::compute {
+// Element types the primitives run on, all 4 bytes wide in WGSL
+template <typename T>
+concept PrimitiveElement = std::same_as<T, uint32_t> ||
+                           std::same_as<T, int32_t> || std::same_as<T, float>;
+
+// Associative operators for Reduce and Scan. WGSL is the body of combine(a, b)
+// in the shaders; the CPU references call Apply.
+struct Sum {
+  static constexpr std::string_view WGSL = "a + b";
+  template <PrimitiveElement T> static constexpr auto Identity() -> T {
+    return T{0};
+  }
+  template <PrimitiveElement T> static constexpr auto Apply(T a, T b) -> T {
+    return a + b;
+  }
+};
+
+struct Min {
+  static constexpr std::string_view WGSL = "min(a, b)";
+  template <PrimitiveElement T> static constexpr auto Identity() -> T {
+    return std::numeric_limits<T>::max();
+  }
+  template <PrimitiveElement T> static constexpr auto Apply(T a, T b) -> T {
+    return std::min(a, b);
+  }
+};
+
+struct Max {
+  static constexpr std::string_view WGSL = "max(a, b)";
+  template <PrimitiveElement T> static constexpr auto Identity() -> T {
+    return std::numeric_limits<T>::lowest();
+  }
+  template <PrimitiveElement T> static constexpr auto Apply(T a, T b) -> T {
+    return std::max(a, b);
+  }
+};
+
+template <typename Op, typename T>
+concept PrimitiveOp = PrimitiveElement<T> && requires(T a) {
+  { Op::WGSL } -> std::convertible_to<std::string_view>;
+  { Op::template Identity<T>() } -> std::same_as<T>;
+  { Op::template Apply<T>(a, a) } -> std::same_as<T>;
+};
+
+// A workgroup handles one tile of PRIMITIVE_TILE_SIZE elements
+constexpr uint32_t PRIMITIVE_WORKGROUP_SIZE = 256;
+constexpr uint32_t PRIMITIVE_ITEMS_PER_THREAD = 4;
+constexpr uint32_t PRIMITIVE_TILE_SIZE =
+    PRIMITIVE_WORKGROUP_SIZE * PRIMITIVE_ITEMS_PER_THREAD;
+// A level dispatches one workgroup per tile, and WebGPU allows 65535 of them
+// per dimension
+constexpr uint32_t PRIMITIVE_MAX_ELEMENTS = 65535 * PRIMITIVE_TILE_SIZE;
+
+// Parameters of one dispatch. Every dispatch of a pass reads its own slot of
+// one uniform buffer, and uniform bindings start at multiples of 256 bytes.
+struct alignas(256) PrimitiveParams {
+  uint32_t count{0};
+  uint32_t exclusive{0};
+  // Scans read 1 for every element that is not 0, see ScanInput
+  uint32_t flags{0};
+};
+
+// Workgroups covering `count` elements, at least one so a pass over nothing
+// still writes the identity
+inline auto primitiveTiles(uint32_t count) -> uint32_t {
+  return std::max(1u, util::divCeil(count, PRIMITIVE_TILE_SIZE));
+}
+
+// Element counts of the levels of a multi-level pass over `count` elements:
+// each level holds one value per tile of the level before, and the last fits
+// in a single tile
+inline auto primitiveLevels(uint32_t count) -> std::vector<uint32_t> {
+  std::vector<uint32_t> levels{count};
+  while (levels.back() > PRIMITIVE_TILE_SIZE) {
+    levels.push_back(primitiveTiles(levels.back()));
+  }
+  return levels;
+}
+
+template <PrimitiveElement T> constexpr auto wgslType() -> std::string_view {
+  if constexpr (std::same_as<T, uint32_t>) {
+    return "u32";
+  } else if constexpr (std::same_as<T, int32_t>) {
+    return "i32";
+  } else {
+    return "f32";
+  }
+}
+
+// Declarations every primitive shader is specialized with; see
+// ComputePipelineInfo::prelude
+template <PrimitiveElement T, PrimitiveOp<T> Op>
+auto primitivePrelude() -> std::string {
+  // Written as a conversion of an abstract literal, so the lowest i32 and
+  // the largest f32 are valid WGSL
+  return std::format(R"(alias T = {0};
+const WORKGROUP_SIZE: u32 = {1}u;
+const ITEMS_PER_THREAD: u32 = {2}u;
+const TILE_SIZE: u32 = {3}u;
+
+struct Params {{
+    count: u32,
+    exclusive: u32,
+    flags: u32,
+}};
+
+fn identity() -> T {{
+    return {0}({4});
+}}
+
+fn combine(a: T, b: T) -> T {{
+    return {5};
+}}
+
+)",
+                     wgslType<T>(), PRIMITIVE_WORKGROUP_SIZE,
+                     PRIMITIVE_ITEMS_PER_THREAD, PRIMITIVE_TILE_SIZE,
+                     Op::template Identity<T>(), Op::WGSL);
+}
+
+// Storage buffer of `count` elements the primitives read and write, which
+// can be copied to and from
+template <PrimitiveElement T>
+auto createPrimitiveBuffer(const wgpu::Device &device, uint32_t count)
+    -> wgpu::Buffer {
+  return util::createBuffer < T,
+         wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc |
+             wgpu::BufferUsage::CopyDst > (device, std::max(count, 1u));
+}
+
+// CPU references. Floating point results of the GPU combine in another order
+// and may differ in the last bits.
+template <PrimitiveElement T, PrimitiveOp<T> Op = Sum>
+auto ReduceReference(std::span<const T> values) -> T {
+  auto acc = Op::template Identity<T>();
+  for (const auto value : values) {
+    acc = Op::template Apply<T>(acc, value);
+  }
+  return acc;
+}
+
+template <PrimitiveElement T, PrimitiveOp<T> Op = Sum>
+auto InclusiveScanReference(std::span<const T> values) -> std::vector<T> {
+  std::vector<T> result;
+  result.reserve(values.size());
+  auto acc = Op::template Identity<T>();
+  for (const auto value : values) {
+    acc = Op::template Apply<T>(acc, value);
+    result.push_back(acc);
+  }
+  return result;
+}
+
+template <PrimitiveElement T, PrimitiveOp<T> Op = Sum>
+auto ExclusiveScanReference(std::span<const T> values) -> std::vector<T> {
+  std::vector<T> result;
+  result.reserve(values.size());
+  auto acc = Op::template Identity<T>();
+  for (const auto value : values) {
+    result.push_back(acc);
+    acc = Op::template Apply<T>(acc, value);
+  }
+  return result;
+}
+
+// The values whose flag is not 0, in order
+template <PrimitiveElement T>
+auto CompactReference(std::span<const T> values,
+                      std::span<const uint32_t> flags) -> std::vector<T> {
+  std::vector<T> result;
+  for (size_t i = 0; i < values.size() && i < flags.size(); ++i) {
+    if (flags[i] != 0) {
+      result.push_back(values[i]);
+    }
+  }
+  return result;
+}
+} // namespace wglib::compute
@@ -0,0 +1,190 @@
+#include "RadixSort.hpp"
+#include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <format>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wglib::compute {
+RadixSortLayer::RadixSortLayer(uint32_t capacity, bool withValues)
+    : m_capacity(capacity), m_withValues(withValues) {}
+
+RadixSortLayer::RadixSortLayer(std::vector<uint32_t> keys)
+    : m_capacity(static_cast<uint32_t>(keys.size())), m_withValues(false),
+      m_keys(std::move(keys)) {}
+
+RadixSortLayer::RadixSortLayer(std::vector<uint32_t> keys,
+                               std::vector<uint32_t> values)
+    : m_capacity(static_cast<uint32_t>(keys.size())), m_withValues(true),
+      m_keys(std::move(keys)), m_values(std::move(values)) {
+  assert(m_values.size() == m_keys->size() && "Every key needs a value");
+}
+
+auto RadixSortLayer::InitImpl(wgpu::Device &device) -> void {
+  assert(m_capacity <= PRIMITIVE_MAX_ELEMENTS && "Sort capacity too large");
+  m_device = device;
+  const auto tiles = primitiveTiles(m_capacity);
+  m_scan.Init(device, RADIX * tiles);
+
+  auto &cache = PipelineCache::Get(device);
+  const auto prelude = primitivePrelude<uint32_t, Sum>() +
+                       std::format("const RADIX: u32 = {}u;\n\n", RADIX);
+  m_histogramPipeline = cache.GetComputePipeline(
+      {.shaderPath = "../src/shaders/Primitives/radix_histogram.wgsl",
+       .prelude = prelude});
+  // The keys-only entry point has no value bindings, so a keys-only sort
+  // never binds a buffer twice
+  m_scatterPipeline = cache.GetComputePipeline(
+      {.shaderPath = "../src/shaders/Primitives/radix_scatter.wgsl",
+       .entryPoint = m_withValues ? "scatter_pairs" : "scatter_keys",
+       .prelude = prelude});
+  m_histogramLayout = m_histogramPipeline.GetBindGroupLayout(0);
+  m_scatterLayout = m_scatterPipeline.GetBindGroupLayout(0);
+
+  m_params = util::createBuffer < Params,
+  wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst > (device, PASSES);
+  m_histograms = createPrimitiveBuffer<uint32_t>(device, RADIX * tiles);
+  m_offsets = createPrimitiveBuffer<uint32_t>(device, RADIX * tiles);
+  m_scratchKeys = createPrimitiveBuffer<uint32_t>(device, m_capacity);
+  if (m_withValues) {
+    m_scratchValues = createPrimitiveBuffer<uint32_t>(device, m_capacity);
+  }
+
+  if (m_keys) {
+    m_buffers.keys = createPrimitiveBuffer<uint32_t>(device, m_capacity);
+    if (m_withValues) {
+      m_buffers.values = createPrimitiveBuffer<uint32_t>(device, m_capacity);
+    }
+  }
+}
+
+auto RadixSortLayer::count() const -> uint32_t {
+  auto count = std::min(
+      m_capacity, static_cast<uint32_t>(m_buffers.keys.GetSize() / 4));
+  if (m_withValues) {
+    count = std::min(count,
+                     static_cast<uint32_t>(m_buffers.values.GetSize() / 4));
+  }
+  return count;
+}
+
+auto RadixSortLayer::getResultImpl() -> const SortBuffers & {
+  return m_buffers;
+}
+
+auto RadixSortLayer::DeclareImpl(RenderGraph::PassBuilder &builder) -> void {
+  // Sorted in place
+  if (m_buffers.keys) {
+    builder.Write(builder.Read(builder.Import("SortKeys", m_buffers.keys)));
+  }
+  if (m_buffers.values) {
+    builder.Write(builder.Read(builder.Import("SortValues", m_buffers.values)));
+  }
+}
+
+auto RadixSortLayer::ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q)
+    -> void {
+  if (not m_buffers.keys || (m_withValues && not m_buffers.values)) {
+    util::log("RadixSortLayer has no input");
+    return;
+  }
+  if (m_keys) {
+    // Sorting overwrites them, so every run starts from the original keys
+    q.WriteBuffer(m_buffers.keys, 0, m_keys->data(),
+                  m_keys->size() * sizeof(uint32_t));
+    if (m_withValues) {
+      q.WriteBuffer(m_buffers.values, 0, m_values.data(),
+                    m_values.size() * sizeof(uint32_t));
+    }
+  }
+
+  const auto keyCount = count();
+  if (keyCount < 2) {
+    return;
+  }
+  const auto tiles = primitiveTiles(keyCount);
+  if (keyCount != m_writtenCount) {
+    std::array<Params, PASSES> params;
+    for (uint32_t pass = 0; pass < PASSES; ++pass) {
+      params[pass] = {
+          .count = keyCount, .shift = pass * DIGIT_BITS, .tiles = tiles};
+    }
+    q.WriteBuffer(m_params, 0, params.data(), sizeof(params));
+    m_writtenCount = keyCount;
+  }
+
+  auto &cache = PipelineCache::Get(m_device);
+  for (uint32_t pass = 0; pass < PASSES; ++pass) {
+    const auto even = pass % 2 == 0;
+    const auto &keysIn = even ? m_buffers.keys : m_scratchKeys;
+    const auto &keysOut = even ? m_scratchKeys : m_buffers.keys;
+    const wgpu::BindGroupEntry paramsEntry{.binding = 0,
+                                           .buffer = m_params,
+                                           .offset = pass * sizeof(Params),
+                                           .size = sizeof(Params)};
+
+    {
+      const wgpu::BindGroupEntry entries[]{
+          paramsEntry,
+          {.binding = 1, .buffer = keysIn},
+          {.binding = 2, .buffer = m_histograms},
+      };
+      auto histogramPass = e.BeginComputePass();
+      histogramPass.SetPipeline(m_histogramPipeline);
+      histogramPass.SetBindGroup(
+          0, cache.GetBindGroup(m_histogramLayout, entries));
+      histogramPass.DispatchWorkgroups(tiles);
+      histogramPass.End();
+    }
+
+    m_scan.Record(e, q, m_histograms, m_offsets, RADIX * tiles,
+                  ScanKind::Exclusive);
+
+    std::vector<wgpu::BindGroupEntry> entries{
+        paramsEntry,
+        {.binding = 1, .buffer = keysIn},
+        {.binding = 2, .buffer = keysOut},
+        {.binding = 5, .buffer = m_offsets},
+    };
+    if (m_withValues) {
+      entries.push_back(
+          {.binding = 3, .buffer = even ? m_buffers.values : m_scratchValues});
+      entries.push_back(
+          {.binding = 4, .buffer = even ? m_scratchValues : m_buffers.values});
+    }
+    auto scatterPass = e.BeginComputePass();
+    scatterPass.SetPipeline(m_scatterPipeline);
+    scatterPass.SetBindGroup(0, cache.GetBindGroup(m_scatterLayout, entries));
+    scatterPass.DispatchWorkgroups(tiles);
+    scatterPass.End();
+  }
+}
+
+auto RadixSortLayer::OutputImpl() const -> ComputeOutput {
+  return {.buffer = m_buffers.keys};
+}
+
+auto RadixSortLayer::AdditionalOutputImpl(uint32_t output) const
+    -> ComputeOutput {
+  if (output != 1) {
+    return {};
+  }
+  return {.buffer = m_buffers.values};
+}
+
+auto RadixSortLayer::SetInputImpl(uint32_t slot, const ComputeOutput &input)
+    -> void {
+  if (not input.buffer) {
+    return;
+  }
+  if (slot == 0) {
+    m_buffers.keys = input.buffer;
+  } else if (slot == 1 && m_withValues) {
+    m_buffers.values = input.buffer;
+  }
+}
+} // namespace wglib::compute
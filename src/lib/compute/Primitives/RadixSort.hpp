@@ -0,0 +1,82 @@
+#pragma once
+#include "Scan.hpp"
+#include "lib/compute/ComputeLayer.hpp"
+#include "webgpu/webgpu_cpp.h"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace wglib::compute {
+// What RadixSortLayer sorts; `values` is null when it sorts keys only
+struct SortBuffers {
+  wgpu::Buffer keys;
+  wgpu::Buffer values;
+};
+
+// Stable least-significant-digit radix sort of uint32 keys, optionally
+// moving a uint32 value along with each key, in place in storage buffers of
+// up to `capacity` elements.
+//
+// Every pass sorts by one DIGIT_BITS-wide digit in three steps: each
+// workgroup counts the digits of its tile into a per-workgroup histogram,
+// an exclusive scan of all histograms gives every tile the first position
+// of each digit, and each workgroup scatters its keys there, ranked in
+// shared memory so keys with equal digits keep their order. The keys go back
+// and forth between the sorted buffer and a scratch buffer, and an even
+// number of passes leaves them in the sorted buffer.
+//
+// Created with keys, the layer uploads and sorts them every time it runs.
+// With only a capacity it sorts the buffers handed to input slots 0 (keys)
+// and 1 (values) of a ComputeGraph. Readers in the graph get the keys as
+// output 0 and the values as output 1, see ComputeGraph::ConnectOutput.
+class RadixSortLayer : public ComputeLayer<const SortBuffers &> {
+public:
+  // Four-bit digits keep the per-lane digit counters of the scatter at eight
+  // words of shared memory
+  static constexpr uint32_t DIGIT_BITS = 4;
+  static constexpr uint32_t RADIX = 1u << DIGIT_BITS;
+  static constexpr uint32_t PASSES = 32 / DIGIT_BITS;
+  static_assert(PASSES % 2 == 0, "The last pass must write the sorted buffer");
+
+private:
+  // One slot per pass of a uniform buffer, see PrimitiveParams
+  struct alignas(256) Params {
+    uint32_t count{0};
+    uint32_t shift{0};
+    uint32_t tiles{0};
+  };
+
+  ScanPasses<uint32_t> m_scan;
+  wgpu::Device m_device;
+  wgpu::ComputePipeline m_histogramPipeline, m_scatterPipeline;
+  wgpu::BindGroupLayout m_histogramLayout, m_scatterLayout;
+  wgpu::Buffer m_params;
+  // RADIX counts per tile, digit-major, and their exclusive scan
+  wgpu::Buffer m_histograms, m_offsets;
+  wgpu::Buffer m_scratchKeys, m_scratchValues;
+  SortBuffers m_buffers;
+  uint32_t m_capacity;
+  bool m_withValues;
+  uint32_t m_writtenCount{UINT32_MAX};
+  // Uploaded every run when the layer is created with keys
+  std::optional<std::vector<uint32_t>> m_keys;
+  std::vector<uint32_t> m_values;
+
+  auto count() const -> uint32_t;
+
+public:
+  explicit RadixSortLayer(uint32_t capacity, bool withValues = false);
+  explicit RadixSortLayer(std::vector<uint32_t> keys);
+  RadixSortLayer(std::vector<uint32_t> keys, std::vector<uint32_t> values);
+
+protected:
+  auto getResultImpl() -> const SortBuffers & override;
+  auto InitImpl(wgpu::Device &device) -> void override;
+  auto DeclareImpl(RenderGraph::PassBuilder &builder) -> void override;
+  auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void override;
+  auto OutputImpl() const -> ComputeOutput override;
+  auto AdditionalOutputImpl(uint32_t output) const -> ComputeOutput override;
+  auto SetInputImpl(uint32_t slot, const ComputeOutput &input)
+      -> void override;
+};
+} // namespace wglib::compute
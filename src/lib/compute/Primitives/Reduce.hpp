@@ -0,0 +1,132 @@
+#pragma once
+#include "Primitives.hpp"
+#include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
+#include "lib/compute/ComputeLayer.hpp"
+#include "webgpu/webgpu_cpp.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace wglib::compute {
+// Reduction of a storage buffer of up to `capacity` elements with Op into a
+// one-element buffer. Every workgroup reduces one tile in shared memory into
+// a partial result, and the partials are reduced the same way, one level up,
+// until a single tile is left, whose workgroup writes the result.
+//
+// The input is either uploaded once from the values the layer is created
+// with, or the buffer handed to input slot 0 in a ComputeGraph, all of which
+// is reduced up to the capacity. The result stays on the GPU; connect the
+// layer to a ReadbackLayer to read it.
+template <PrimitiveElement T, PrimitiveOp<T> Op = Sum>
+class Reduce : public ComputeLayer<const wgpu::Buffer &> {
+  wgpu::Device m_device;
+  wgpu::ComputePipeline m_pipeline;
+  wgpu::BindGroupLayout m_layout;
+  // One PrimitiveParams slot per level
+  wgpu::Buffer m_params;
+  // Partial results of every level but the last, which writes m_result
+  std::vector<wgpu::Buffer> m_partials;
+  wgpu::Buffer m_input, m_result;
+  uint32_t m_capacity;
+  uint32_t m_count{0};
+  uint32_t m_writtenCount{UINT32_MAX};
+  // Uploaded by InitImpl when the layer is created with values
+  std::optional<std::vector<T>> m_values;
+
+public:
+  explicit Reduce(uint32_t capacity) : m_capacity(capacity) {}
+
+  explicit Reduce(std::vector<T> values)
+      : m_capacity(static_cast<uint32_t>(values.size())), m_count(m_capacity),
+        m_values(std::move(values)) {}
+
+protected:
+  auto getResultImpl() -> const wgpu::Buffer & override { return m_result; }
+
+  auto InitImpl(wgpu::Device &device) -> void override {
+    assert(m_capacity <= PRIMITIVE_MAX_ELEMENTS && "Reduce capacity too large");
+    m_device = device;
+    m_pipeline = PipelineCache::Get(device).GetComputePipeline(
+        {.shaderPath = "../src/shaders/Primitives/reduce.wgsl",
+         .prelude = primitivePrelude<T, Op>()});
+    m_layout = m_pipeline.GetBindGroupLayout(0);
+
+    const auto levels = primitiveLevels(m_capacity);
+    m_params = util::createBuffer < PrimitiveParams,
+    wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst >
+        (device, levels.size());
+    for (size_t level = 1; level < levels.size(); ++level) {
+      m_partials.push_back(createPrimitiveBuffer<T>(device, levels[level]));
+    }
+    m_result = createPrimitiveBuffer<T>(device, 1);
+
+    if (m_values) {
+      m_input = createPrimitiveBuffer<T>(device, m_capacity);
+      device.GetQueue().WriteBuffer(m_input, 0, m_values->data(),
+                                    m_values->size() * sizeof(T));
+      m_values.reset();
+    }
+  }
+
+  auto DeclareImpl(RenderGraph::PassBuilder &builder) -> void override {
+    if (m_input) {
+      builder.Read(builder.Import("ReduceInput", m_input));
+    }
+    builder.Write(builder.Import("Reduce", m_result));
+  }
+
+  auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void override {
+    if (not m_input) {
+      util::log("Reduce has no input");
+      return;
+    }
+
+    const auto levels = primitiveLevels(m_count);
+    if (m_count != m_writtenCount) {
+      std::vector<PrimitiveParams> params;
+      for (const auto count : levels) {
+        params.push_back({.count = count});
+      }
+      q.WriteBuffer(m_params, 0, params.data(),
+                    params.size() * sizeof(PrimitiveParams));
+      m_writtenCount = m_count;
+    }
+
+    auto &cache = PipelineCache::Get(m_device);
+    auto pass = e.BeginComputePass();
+    pass.SetPipeline(m_pipeline);
+    for (size_t level = 0; level < levels.size(); ++level) {
+      const auto last = level + 1 == levels.size();
+      const wgpu::BindGroupEntry entries[]{
+          {.binding = 0,
+           .buffer = m_params,
+           .offset = level * sizeof(PrimitiveParams),
+           .size = sizeof(PrimitiveParams)},
+          {.binding = 1, .buffer = level == 0 ? m_input : m_partials[level - 1]},
+          {.binding = 2, .buffer = last ? m_result : m_partials[level]},
+      };
+      pass.SetBindGroup(0, cache.GetBindGroup(m_layout, entries));
+      pass.DispatchWorkgroups(primitiveTiles(levels[level]));
+    }
+    pass.End();
+  }
+
+  auto OutputImpl() const -> ComputeOutput override {
+    return {.buffer = m_result};
+  }
+
+  auto SetInputImpl(uint32_t slot, const ComputeOutput &input)
+      -> void override {
+    if (slot != 0 || not input.buffer) {
+      return;
+    }
+    m_input = input.buffer;
+    m_count = std::min(
+        m_capacity, static_cast<uint32_t>(input.buffer.GetSize() / sizeof(T)));
+  }
+};
+} // namespace wglib::compute
@@ -0,0 +1,234 @@
+#pragma once
+#include "Primitives.hpp"
+#include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
+#include "lib/compute/ComputeLayer.hpp"
+#include "webgpu/webgpu_cpp.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wglib::compute {
+enum class ScanKind : uint8_t {
+  // Element i combines elements 0 to i
+  Inclusive,
+  // Element i combines elements 0 to i - 1, the first is the identity
+  Exclusive,
+};
+
+// What a scan reads from its input
+enum class ScanInput : uint8_t {
+  // The elements themselves
+  Values,
+  // 1 for every element that is not 0 and 0 for the others, so the scan of
+  // the flags of a stream compaction counts the kept elements whatever
+  // non-zero value marks them
+  Flags,
+};
+
+// The passes of a multi-level scan, recorded by the layers built on it.
+//
+// Every workgroup scans one tile in shared memory and writes the tile's
+// total; the totals are scanned the same way, one level up, until they fit
+// in one tile, and each level's scanned totals are then added back into the
+// tiles after the first of the level below. Single-pass decoupled lookback
+// would save the extra passes but spins on other workgroups, which WebGPU
+// gives no forward progress guarantee for.
+template <PrimitiveElement T, PrimitiveOp<T> Op = Sum> class ScanPasses {
+  wgpu::Device m_device;
+  wgpu::ComputePipeline m_scanPipeline, m_addPipeline;
+  wgpu::BindGroupLayout m_scanLayout, m_addLayout;
+  // One PrimitiveParams slot per level
+  wgpu::Buffer m_params;
+  // Per level: the totals of its tiles, and above the first level the scan
+  // of the totals of the level below
+  std::vector<wgpu::Buffer> m_tileSums, m_scannedSums;
+  uint32_t m_capacity{0};
+  std::vector<PrimitiveParams> m_written;
+
+public:
+  auto Init(const wgpu::Device &device, uint32_t capacity) -> void;
+
+  // Scans the first `count` elements of `input` into `output`, which must be
+  // different buffers. The parameters are written through the queue, so
+  // every Record of one submission must scan the same count, kind and input.
+  auto Record(wgpu::CommandEncoder &encoder, wgpu::Queue &queue,
+              const wgpu::Buffer &input, const wgpu::Buffer &output,
+              uint32_t count, ScanKind kind,
+              ScanInput read = ScanInput::Values) -> void;
+
+  auto Capacity() const -> uint32_t { return m_capacity; }
+};
+
+template <PrimitiveElement T, PrimitiveOp<T> Op>
+auto ScanPasses<T, Op>::Init(const wgpu::Device &device, uint32_t capacity)
+    -> void {
+  assert(capacity <= PRIMITIVE_MAX_ELEMENTS && "Scan capacity too large");
+  m_device = device;
+  m_capacity = capacity;
+
+  auto &cache = PipelineCache::Get(device);
+  const auto prelude = primitivePrelude<T, Op>();
+  m_scanPipeline = cache.GetComputePipeline(
+      {.shaderPath = "../src/shaders/Primitives/scan.wgsl",
+       .prelude = prelude});
+  m_addPipeline = cache.GetComputePipeline(
+      {.shaderPath = "../src/shaders/Primitives/scan_add.wgsl",
+       .prelude = prelude});
+  m_scanLayout = m_scanPipeline.GetBindGroupLayout(0);
+  m_addLayout = m_addPipeline.GetBindGroupLayout(0);
+
+  const auto levels = primitiveLevels(capacity);
+  m_params = util::createBuffer < PrimitiveParams,
+  wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst >
+      (device, levels.size());
+  m_tileSums.clear();
+  m_scannedSums.clear();
+  for (size_t level = 0; level < levels.size(); ++level) {
+    m_tileSums.push_back(
+        createPrimitiveBuffer<T>(device, primitiveTiles(levels[level])));
+    if (level > 0) {
+      m_scannedSums.push_back(createPrimitiveBuffer<T>(device, levels[level]));
+    }
+  }
+  m_written.clear();
+}
+
+template <PrimitiveElement T, PrimitiveOp<T> Op>
+auto ScanPasses<T, Op>::Record(wgpu::CommandEncoder &encoder,
+                               wgpu::Queue &queue, const wgpu::Buffer &input,
+                               const wgpu::Buffer &output, uint32_t count,
+                               ScanKind kind, ScanInput read) -> void {
+  assert(count <= m_capacity && "Scanning more elements than the capacity");
+  const auto levels = primitiveLevels(count);
+
+  // Only the first level is exclusive or reads flags; the levels above scan
+  // tile totals
+  std::vector<PrimitiveParams> params;
+  for (size_t level = 0; level < levels.size(); ++level) {
+    params.push_back(
+        {.count = levels[level],
+         .exclusive = level == 0 && kind == ScanKind::Exclusive ? 1u : 0u,
+         .flags = level == 0 && read == ScanInput::Flags ? 1u : 0u});
+  }
+  if (not std::ranges::equal(params, m_written, [](const auto &a,
+                                                   const auto &b) {
+        return a.count == b.count && a.exclusive == b.exclusive &&
+               a.flags == b.flags;
+      })) {
+    queue.WriteBuffer(m_params, 0, params.data(),
+                      params.size() * sizeof(PrimitiveParams));
+    m_written = std::move(params);
+  }
+
+  auto &cache = PipelineCache::Get(m_device);
+  auto paramsEntry = [&](size_t level) {
+    return wgpu::BindGroupEntry{.binding = 0,
+                                .buffer = m_params,
+                                .offset = level * sizeof(PrimitiveParams),
+                                .size = sizeof(PrimitiveParams)};
+  };
+  // What level `level` scans into, and the tiles the add pass updates
+  auto levelOutput = [&](size_t level) -> const wgpu::Buffer & {
+    return level == 0 ? output : m_scannedSums[level - 1];
+  };
+
+  auto pass = encoder.BeginComputePass();
+  pass.SetPipeline(m_scanPipeline);
+  for (size_t level = 0; level < levels.size(); ++level) {
+    const wgpu::BindGroupEntry entries[]{
+        paramsEntry(level),
+        {.binding = 1,
+         .buffer = level == 0 ? input : m_tileSums[level - 1]},
+        {.binding = 2, .buffer = levelOutput(level)},
+        {.binding = 3, .buffer = m_tileSums[level]},
+    };
+    pass.SetBindGroup(0, cache.GetBindGroup(m_scanLayout, entries));
+    pass.DispatchWorkgroups(primitiveTiles(levels[level]));
+  }
+
+  // Top down, so the totals added into a level are complete
+  pass.SetPipeline(m_addPipeline);
+  for (size_t level = levels.size() - 1; level-- > 0;) {
+    const wgpu::BindGroupEntry entries[]{
+        paramsEntry(level),
+        {.binding = 1, .buffer = m_scannedSums[level]},
+        {.binding = 2, .buffer = levelOutput(level)},
+    };
+    pass.SetBindGroup(0, cache.GetBindGroup(m_addLayout, entries));
+    pass.DispatchWorkgroups(primitiveTiles(levels[level]) - 1);
+  }
+  pass.End();
+}
+
+// Inclusive or exclusive scan of a storage buffer of up to `capacity`
+// elements. The input is either uploaded once from the values the layer is
+// created with, or the buffer handed to input slot 0 in a ComputeGraph, all
+// of which is scanned up to the capacity. The result is the output buffer,
+// which stays on the GPU; connect the layer to a ReadbackLayer to read it.
+template <PrimitiveElement T, PrimitiveOp<T> Op = Sum>
+class Scan : public ComputeLayer<const wgpu::Buffer &> {
+  ScanPasses<T, Op> m_passes;
+  ScanKind m_kind;
+  uint32_t m_capacity;
+  uint32_t m_count{0};
+  wgpu::Buffer m_input, m_output;
+  // Uploaded by InitImpl when the layer is created with values
+  std::optional<std::vector<T>> m_values;
+
+public:
+  explicit Scan(uint32_t capacity, ScanKind kind = ScanKind::Inclusive)
+      : m_kind(kind), m_capacity(capacity) {}
+
+  explicit Scan(std::vector<T> values, ScanKind kind = ScanKind::Inclusive)
+      : m_kind(kind), m_capacity(static_cast<uint32_t>(values.size())),
+        m_count(m_capacity), m_values(std::move(values)) {}
+
+protected:
+  auto getResultImpl() -> const wgpu::Buffer & override { return m_output; }
+
+  auto InitImpl(wgpu::Device &device) -> void override {
+    m_passes.Init(device, m_capacity);
+    m_output = createPrimitiveBuffer<T>(device, m_capacity);
+    if (m_values) {
+      m_input = createPrimitiveBuffer<T>(device, m_capacity);
+      device.GetQueue().WriteBuffer(m_input, 0, m_values->data(),
+                                    m_values->size() * sizeof(T));
+      m_values.reset();
+    }
+  }
+
+  auto DeclareImpl(RenderGraph::PassBuilder &builder) -> void override {
+    if (m_input) {
+      builder.Read(builder.Import("ScanInput", m_input));
+    }
+    builder.Write(builder.Import("Scan", m_output));
+  }
+
+  auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &q) -> void override {
+    if (not m_input) {
+      util::log("Scan has no input");
+      return;
+    }
+    m_passes.Record(e, q, m_input, m_output, m_count, m_kind);
+  }
+
+  auto OutputImpl() const -> ComputeOutput override {
+    return {.buffer = m_output};
+  }
+
+  auto SetInputImpl(uint32_t slot, const ComputeOutput &input)
+      -> void override {
+    if (slot != 0 || not input.buffer) {
+      return;
+    }
+    m_input = input.buffer;
+    m_count = std::min(
+        m_capacity, static_cast<uint32_t>(input.buffer.GetSize() / sizeof(T)));
+  }
+};
+} // namespace wglib::compute
@@ -0,0 +1,105 @@
+#include "Readback.hpp"
+#include "lib/CoreUtil.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace wglib::compute {
+auto ReadbackSlot::Release() -> void {
+  buffer.Unmap();
+  state = State::Free;
+}
+
+auto ReadbackRing::Init(const wgpu::Device &device, uint64_t size,
+                        uint32_t count) -> void {
+  assert(size % 4 == 0 && "Buffer copies are made in multiples of 4 bytes");
+  m_device = device;
+  m_size = size;
+  m_slots.clear();
+  m_pending.clear();
+  for (uint32_t i = 0; i < count; ++i) {
+    createSlot();
+  }
+}
+
+auto ReadbackRing::createSlot() -> std::shared_ptr<ReadbackSlot> {
+  const wgpu::BufferDescriptor desc{
+      .label = "ReadbackStaging",
+      .usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst,
+      .size = m_size,
+  };
+  auto slot = std::make_shared<ReadbackSlot>(
+      ReadbackSlot{.buffer = m_device.CreateBuffer(&desc), .size = m_size});
+  m_slots.push_back(slot);
+  return slot;
+}
+
+auto ReadbackRing::Record(wgpu::CommandEncoder &encoder,
+                          const wgpu::Buffer &source, uint64_t offset)
+    -> void {
+  auto it = std::ranges::find_if(m_slots, [](const auto &slot) {
+    return slot->state == ReadbackSlot::State::Free;
+  });
+  // Every buffer is in flight or still viewed
+  auto slot = it != m_slots.end() ? *it : createSlot();
+  if (it == m_slots.end()) {
+    util::log("ReadbackRing grew to {} buffers", m_slots.size());
+  }
+
+  encoder.CopyBufferToBuffer(source, offset, slot->buffer, 0, m_size);
+  slot->state = ReadbackSlot::State::Recorded;
+  m_pending.push_back(std::move(slot));
+}
+
+auto ReadbackRing::Submitted() -> void {
+  for (const auto &slot : m_pending) {
+    if (slot->state != ReadbackSlot::State::Recorded) {
+      continue;
+    }
+    slot->state = ReadbackSlot::State::Mapping;
+    // Requested before the engine's completion callback for the same
+    // submission, so Dawn delivers it first from ProcessEvents
+    slot->buffer.MapAsync(
+        wgpu::MapMode::Read, 0, m_size, wgpu::CallbackMode::AllowProcessEvents,
+        [slot](wgpu::MapAsyncStatus status, wgpu::StringView error) {
+          if (status != wgpu::MapAsyncStatus::Success) {
+            util::log("Failed to map readback buffer: {}", error.data);
+            // Still queued unless already taken, so Record must not reuse it
+            slot->state = slot->state == ReadbackSlot::State::Dropped
+                              ? ReadbackSlot::State::Free
+                              : ReadbackSlot::State::Failed;
+          } else if (slot->state == ReadbackSlot::State::Dropped) {
+            slot->Release();
+          } else {
+            slot->state = ReadbackSlot::State::Mapped;
+          }
+        });
+  }
+}
+
+auto ReadbackRing::takeSlot() -> std::shared_ptr<ReadbackSlot> {
+  if (m_pending.empty()) {
+    return nullptr;
+  }
+  auto slot = std::move(m_pending.front());
+  m_pending.pop_front();
+
+  switch (slot->state) {
+  case ReadbackSlot::State::Mapped:
+    slot->state = ReadbackSlot::State::Viewed;
+    return slot;
+  case ReadbackSlot::State::Mapping:
+    slot->state = ReadbackSlot::State::Dropped;
+    return nullptr;
+  case ReadbackSlot::State::Recorded:
+    // Not submitted yet; nothing will map it
+    slot->state = ReadbackSlot::State::Free;
+    return nullptr;
+  case ReadbackSlot::State::Failed:
+    // The map failed; the buffer is no longer queued and free again
+    slot->state = ReadbackSlot::State::Free;
+    return nullptr;
+  default:
+    return nullptr;
+  }
+}
+} // namespace wglib::compute
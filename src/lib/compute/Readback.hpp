@@ -0,0 +1,134 @@
+#pragma once
+#include "webgpu/webgpu_cpp.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace wglib::compute {
+// A MapRead staging buffer shared by a ReadbackRing and the view of its
+// contents, so a view may outlive the ring
+struct ReadbackSlot {
+  enum class State : uint8_t {
+    Free,
+    // Copy recorded, waiting for the submit
+    Recorded,
+    Mapping,
+    Mapped,
+    // Handed out as a ReadbackView
+    Viewed,
+    // Taken before the map completed; unmapped and freed when it does
+    Dropped,
+    // The map failed while still pending; freed once taken
+    Failed,
+  };
+
+  wgpu::Buffer buffer;
+  uint64_t size;
+  State state{State::Free};
+
+  // Unmaps the buffer and hands it back to the ring
+  auto Release() -> void;
+};
+
+// Read-only view of a mapped staging buffer. Unmaps the buffer and returns it
+// to its ring when destroyed, so hold it only as long as the data is needed.
+template <typename T> class ReadbackView {
+  friend class ReadbackRing;
+
+  std::shared_ptr<ReadbackSlot> m_slot;
+  std::span<const T> m_data;
+
+  explicit ReadbackView(std::shared_ptr<ReadbackSlot> slot)
+      : m_slot(std::move(slot)),
+        m_data(static_cast<const T *>(
+                   m_slot->buffer.GetConstMappedRange(0, m_slot->size)),
+               m_slot->size / sizeof(T)) {}
+
+  auto release() -> void {
+    if (m_slot) {
+      m_slot->Release();
+      m_slot.reset();
+    }
+  }
+
+public:
+  ReadbackView(const ReadbackView &) = delete;
+  auto operator=(const ReadbackView &) -> ReadbackView & = delete;
+
+  ReadbackView(ReadbackView &&other) noexcept
+      : m_slot(std::move(other.m_slot)), m_data(std::exchange(other.m_data, {})) {
+  }
+
+  auto operator=(ReadbackView &&other) noexcept -> ReadbackView & {
+    if (this != &other) {
+      release();
+      m_slot = std::move(other.m_slot);
+      m_data = std::exchange(other.m_data, {});
+    }
+    return *this;
+  }
+
+  ~ReadbackView() { release(); }
+
+  auto Span() const -> std::span<const T> { return m_data; }
+  auto data() const -> const T * { return m_data.data(); }
+  auto size() const -> size_t { return m_data.size(); }
+  auto begin() const { return m_data.begin(); }
+  auto end() const { return m_data.end(); }
+  auto operator[](size_t index) const -> const T & { return m_data[index]; }
+};
+
+// Staging buffers a compute layer copies its results into, one per step in
+// flight. ComputeImpl records the copy, SubmittedImpl maps the buffers copied
+// into, and getResultImpl takes the oldest one as a ReadbackView. Buffers come
+// back once their view is destroyed, so continuous readback reuses the same
+// few buffers; the ring only grows when every buffer is in flight or viewed.
+//
+// Record once per step whose result is taken: completions take results in
+// submission order. Only used from the thread driving the engine.
+class ReadbackRing {
+  wgpu::Device m_device;
+  uint64_t m_size{0};
+  std::vector<std::shared_ptr<ReadbackSlot>> m_slots;
+  // Recorded or mapping, oldest first
+  std::deque<std::shared_ptr<ReadbackSlot>> m_pending;
+
+  auto createSlot() -> std::shared_ptr<ReadbackSlot>;
+  auto takeSlot() -> std::shared_ptr<ReadbackSlot>;
+
+public:
+  // `count` staging buffers of `size` bytes are created up front
+  auto Init(const wgpu::Device &device, uint64_t size, uint32_t count) -> void;
+
+  // Records a copy of Size() bytes of `source`, starting at `offset`, into a
+  // free staging buffer
+  auto Record(wgpu::CommandEncoder &encoder, const wgpu::Buffer &source,
+              uint64_t offset = 0) -> void;
+
+  // Maps the buffers recorded since the last call; call once their copies
+  // are submitted
+  auto Submitted() -> void;
+
+  // Contents of the oldest recorded buffer, or nullopt if mapping it failed
+  // or has not completed
+  template <typename T> auto Take() -> std::optional<ReadbackView<T>> {
+    auto slot = takeSlot();
+    if (not slot) {
+      return std::nullopt;
+    }
+    return ReadbackView<T>(std::move(slot));
+  }
+
+  auto Size() const -> uint64_t { return m_size; }
+
+  // Staging buffers created so far
+  auto Capacity() const -> uint32_t {
+    return static_cast<uint32_t>(m_slots.size());
+  }
+};
+} // namespace wglib::compute
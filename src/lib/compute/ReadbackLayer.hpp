@@ -0,0 +1,63 @@
+#pragma once
+#include "lib/CoreUtil.hpp"
+#include "lib/compute/ComputeLayer.hpp"
+#include "lib/compute/Readback.hpp"
+#include "webgpu/webgpu_cpp.h"
+#include <optional>
+
+namespace wglib::compute {
+// Reads back the buffer handed to its input slot 0 in a ComputeGraph, so the
+// GPU-side result of another layer reaches the CPU as a ReadbackView. The
+// input needs CopySrc usage. The staging buffers are sized after the input
+// and recreated when a differently sized buffer comes in.
+template <typename T>
+class ReadbackLayer : public ComputeLayer<std::optional<ReadbackView<T>>> {
+  wgpu::Device m_device;
+  wgpu::Buffer m_source;
+  ReadbackRing m_readback;
+
+protected:
+  auto getResultImpl() -> std::optional<ReadbackView<T>> override {
+    auto result = m_readback.Take<T>();
+    if (not result) {
+      util::log("Readback not ready");
+    }
+    return result;
+  }
+
+  auto InitImpl(wgpu::Device &device) -> void override { m_device = device; }
+
+  auto DeclareImpl(RenderGraph::PassBuilder &builder) -> void override {
+    if (m_source) {
+      builder.Read(builder.Import("ReadbackSource", m_source));
+    }
+  }
+
+  auto ComputeImpl(wgpu::CommandEncoder &e, wgpu::Queue &) -> void override {
+    if (not m_source) {
+      util::log("ReadbackLayer has no input");
+      return;
+    }
+    m_readback.Record(e, m_source);
+  }
+
+  // Every step reads back the same buffer
+  auto ComputeIterationsImpl(wgpu::CommandEncoder &e, wgpu::Queue &q,
+                             uint32_t) -> void override {
+    ComputeImpl(e, q);
+  }
+
+  auto SubmittedImpl() -> void override { m_readback.Submitted(); }
+
+  auto SetInputImpl(uint32_t slot, const ComputeOutput &input)
+      -> void override {
+    if (slot != 0 || not input.buffer) {
+      return;
+    }
+    m_source = input.buffer;
+    if (m_readback.Size() != m_source.GetSize()) {
+      m_readback.Init(m_device, m_source.GetSize(), 2);
+    }
+  }
+};
+} // namespace wglib::compute
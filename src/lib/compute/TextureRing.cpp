@@ -0,0 +1,38 @@
+#include "TextureRing.hpp"
+#include <cassert>
+
+namespace wglib::compute {
+auto TextureRing::Init(const wgpu::Device &device,
+                       const wgpu::TextureDescriptor &desc, uint32_t count)
+    -> void {
+  assert(count >= 1 && "A texture ring needs at least one texture");
+  m_textures.clear();
+  m_views.clear();
+  for (uint32_t i = 0; i < count; ++i) {
+    m_textures.push_back(device.CreateTexture(&desc));
+    m_views.push_back(m_textures.back().CreateView());
+  }
+  m_next = 0;
+  m_pending.clear();
+}
+
+auto TextureRing::Advance() -> void {
+  // Results nobody took, e.g. of a layer only read by others in a
+  // ComputeGraph, are dropped once their texture is written again
+  if (m_pending.size() == Size()) {
+    m_pending.pop_front();
+  }
+  m_pending.push_back(m_next);
+  m_next = (m_next + 1) % Size();
+}
+
+auto TextureRing::TakeCompleted() -> const wgpu::Texture & {
+  if (m_pending.empty()) {
+    // Nothing recorded since the last result: the newest output stands
+    return m_textures[(m_next + Size() - 1) % Size()];
+  }
+  const auto index = m_pending.front();
+  m_pending.pop_front();
+  return m_textures[index];
+}
+} // namespace wglib::compute
@@ -0,0 +1,48 @@
+#pragma once
+#include "webgpu/webgpu_cpp.h"
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace wglib::compute {
+// Output textures a compute layer writes in turn. The texture handed to the
+// renderer by one step is not written again before Size() - 1 further steps,
+// so the next step can be recorded while the previous output is still drawn
+// and the layer can be pushed every frame. Size it to the frames in flight
+// plus one; a ring of one texture behaves like a single output texture.
+class TextureRing {
+  std::vector<wgpu::Texture> m_textures;
+  std::vector<wgpu::TextureView> m_views;
+  uint32_t m_next{0};
+  // Written by recorded steps whose results were not taken yet, oldest first
+  std::deque<uint32_t> m_pending;
+
+public:
+  auto Init(const wgpu::Device &device, const wgpu::TextureDescriptor &desc,
+            uint32_t count) -> void;
+
+  auto Size() const -> uint32_t {
+    return static_cast<uint32_t>(m_textures.size());
+  }
+
+  // Texture the step being recorded writes
+  auto NextIndex() const -> uint32_t { return m_next; }
+  auto Next() const -> const wgpu::Texture & { return m_textures[m_next]; }
+
+  auto View(uint32_t index) const -> const wgpu::TextureView & {
+    return m_views[index];
+  }
+
+  auto Textures() const -> std::span<const wgpu::Texture> {
+    return m_textures;
+  }
+
+  // Call once the step writing Next() is recorded
+  auto Advance() -> void;
+
+  // Output of the oldest recorded step not taken yet. Completion callbacks
+  // arrive in submission order, so getResultImpl calls this once per step.
+  auto TakeCompleted() -> const wgpu::Texture &;
+};
+} // namespace wglib::compute
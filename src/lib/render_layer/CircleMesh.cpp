@@ -0,0 +1,113 @@
+#include "CircleMesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/ext/scalar_constants.hpp"
+#include "lib/CoreUtil.hpp"
+
+namespace wglib::render_layers {
+namespace {
+struct Tessellation {
+  std::array<CircleMesh::Level, CircleMesh::SEGMENTS.size()> levels{};
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+auto tessellation() -> const Tessellation & {
+  static const Tessellation mesh = [] {
+    Tessellation t;
+    for (size_t level = 0; level < CircleMesh::SEGMENTS.size(); ++level) {
+      const auto segments = CircleMesh::SEGMENTS[level];
+      t.levels[level] = {
+          .segments = segments,
+          .baseVertex = static_cast<int32_t>(t.vertices.size()),
+          .vertexCount = segments + 1,
+          .firstIndex = static_cast<uint32_t>(t.indices.size()),
+          .indexCount = segments * 3,
+      };
+
+      const Unorm8x4 white{glm::vec4(1.0f)};
+      t.vertices.push_back({glm::vec2(0.0f), white});
+      for (uint32_t i = 0; i < segments; ++i) {
+        const auto angle = static_cast<float>(i) / static_cast<float>(segments) *
+                           2.0f * glm::pi<float>();
+        t.vertices.push_back({{std::cos(angle), std::sin(angle)}, white});
+      }
+      for (uint32_t i = 0; i < segments; ++i) {
+        t.indices.push_back(0);
+        t.indices.push_back(i + 1);
+        t.indices.push_back((i + 1) % segments + 1);
+      }
+    }
+    return t;
+  }();
+  return mesh;
+}
+
+auto registry()
+    -> std::unordered_map<WGPUDevice, std::unique_ptr<CircleMesh>> & {
+  static std::unordered_map<WGPUDevice, std::unique_ptr<CircleMesh>> meshes;
+  return meshes;
+}
+} // namespace
+
+CircleMesh::CircleMesh(const wgpu::Device &device) {
+  // Immutable, so written once through mapped-at-creation buffers
+  const auto vertices = Vertices();
+  m_vertices = util::createBuffer<Vertex, wgpu::BufferUsage::Vertex>(
+      device, vertices.size(), true);
+  m_vertices.WriteMappedRange(0, vertices.data(), vertices.size_bytes());
+  m_vertices.Unmap();
+
+  std::vector<uint16_t> indices;
+  NarrowIndices(Indices(), indices);
+  m_indices = util::createBuffer<uint16_t, wgpu::BufferUsage::Index>(
+      device, indices.size(), true);
+  m_indices.WriteMappedRange(0, indices.data(),
+                             indices.size() * sizeof(uint16_t));
+  m_indices.Unmap();
+}
+
+auto CircleMesh::Get(const wgpu::Device &device) -> const CircleMesh & {
+  auto &mesh = registry()[device.Get()];
+  if (not mesh) {
+    mesh = std::make_unique<CircleMesh>(device);
+  }
+  return *mesh;
+}
+
+auto CircleMesh::Release(const wgpu::Device &device) -> void {
+  registry().erase(device.Get());
+}
+
+auto CircleMesh::Levels() -> std::span<const Level, SEGMENTS.size()> {
+  return tessellation().levels;
+}
+
+auto CircleMesh::Vertices() -> std::span<const Vertex> {
+  return tessellation().vertices;
+}
+
+auto CircleMesh::Indices() -> std::span<const uint32_t> {
+  return tessellation().indices;
+}
+
+auto CircleMesh::LevelForRadius(float radiusPixels) -> uint32_t {
+  // A chord of n segments deviates r * (1 - cos(pi / n)) ~ r * pi^2 / (2n^2)
+  // from the circle; half a pixel needs n >= pi * sqrt(r)
+  const auto segments =
+      glm::pi<float>() * std::sqrt(std::max(radiusPixels, 0.0f));
+  return LevelForSegments(static_cast<uint32_t>(std::ceil(segments)));
+}
+
+auto CircleMesh::LevelForSegments(uint32_t segments) -> uint32_t {
+  const auto it = std::ranges::lower_bound(SEGMENTS, segments);
+  return it == SEGMENTS.end()
+             ? static_cast<uint32_t>(SEGMENTS.size() - 1)
+             : static_cast<uint32_t>(std::distance(SEGMENTS.begin(), it));
+}
+} // namespace wglib::render_layers
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <webgpu/webgpu_cpp.h>
+
+#include "Vertex.hpp"
+
+namespace wglib::render_layers {
+// Unit circles at a few levels of detail, tessellated once per process and
+// uploaded once per device. Every CircleRenderLayer draws one level of the
+// shared buffers, placed and colored by its TransformBuffer slot; the
+// vertices are white so the slot's tint gives the color.
+class CircleMesh {
+public:
+  constexpr static std::array<uint32_t, 5> SEGMENTS{8, 16, 32, 64, 128};
+
+  struct Level {
+    uint32_t segments;
+    // Into Vertices(); indices of a level start at 0
+    int32_t baseVertex;
+    uint32_t vertexCount;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+  };
+
+private:
+  wgpu::Buffer m_vertices;
+  // 16-bit, see Indices()
+  wgpu::Buffer m_indices;
+
+public:
+  explicit CircleMesh(const wgpu::Device &device);
+
+  // One upload per device, created on first use
+  static auto Get(const wgpu::Device &device) -> const CircleMesh &;
+
+  static auto Release(const wgpu::Device &device) -> void;
+
+  static auto Levels() -> std::span<const Level, SEGMENTS.size()>;
+
+  // All levels back to back: a center vertex, then the rim
+  static auto Vertices() -> std::span<const Vertex>;
+
+  static auto Indices() -> std::span<const uint32_t>;
+
+  // Coarsest level whose chords stay within half a pixel of a circle of the
+  // given on-screen radius: 8 segments at 2 px, 128 at 500 px
+  static auto LevelForRadius(float radiusPixels) -> uint32_t;
+
+  // Coarsest level with at least the given segments, or the finest one
+  static auto LevelForSegments(uint32_t segments) -> uint32_t;
+
+  auto VertexBuffer() const -> const wgpu::Buffer & { return m_vertices; }
+
+  auto IndexBuffer() const -> const wgpu::Buffer & { return m_indices; }
+
+  constexpr static auto INDEX_FORMAT = wgpu::IndexFormat::Uint16;
+};
+} // namespace wglib::render_layers
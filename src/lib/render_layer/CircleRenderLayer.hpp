@@ -4,48 +4,56 @@
 #pragma once
 
 #include "RenderLayer.hpp"
-#include "lib/render_layer/Vertex.hpp"
+#include "lib/TransformBuffer.hpp"
+#include "lib/render_layer/CircleMesh.hpp"
 #include "webgpu/webgpu_cpp.h"
 
 namespace wglib::render_layers {
+// Draws one level of the shared CircleMesh. The circle owns no buffers: its
+// origin, radius and color live in its TransformBuffer slot.
 class CircleRenderLayer : public render_layers::RenderLayer {
 public:
-  constexpr static auto DEFAULT_RESOLUTION = 50u;
+  // Picks the level of detail from the radius on screen
+  constexpr static auto AUTO_RESOLUTION = 0u;
 
 private:
   glm::vec2 m_origin;
   float m_radius;
   glm::vec3 m_color;
+  // Requested segments, or AUTO_RESOLUTION
   uint32_t m_resolution;
+  // Index into CircleMesh::Levels()
+  uint32_t m_level{0};
 
-  mutable wgpu::Buffer m_vertex_buffer;
-  mutable bool m_vertex_buffer_dirty{false};
-
-  mutable wgpu::Buffer m_index_buffer;
-  mutable bool m_index_buffer_dirty{false};
-
-  std::vector<uint32_t> m_indices;
-
-  std::vector<Vertex> m_vertices;
+  TransformHandle m_transform;
 
   bool m_isInitialized{false};
 
-  auto calculateVertices() -> void;
-  static std::optional<wgpu::RenderPipeline> m_render_pipeline;
-  static auto initRenderPipeline(const wgpu::Device &, wgpu::TextureFormat,
-                                 const wgpu::BindGroupLayout &) -> void;
+  // Shared by all circles through the PipelineCache
+  wgpu::RenderPipeline m_render_pipeline;
+  // Handles of CircleMesh::Get(device)
+  wgpu::Buffer m_mesh_vertices;
+  wgpu::Buffer m_mesh_indices;
+
+  auto updateLevel() -> void;
+  auto updateTransform() -> void;
 
 public:
+  // A resolution other than AUTO_RESOLUTION is rounded up to the next level,
+  // at most CircleMesh::SEGMENTS.back()
   CircleRenderLayer(glm::vec2 origin, float radius, glm::vec3 color,
-                    uint32_t resolution = DEFAULT_RESOLUTION);
+                    uint32_t resolution = AUTO_RESOLUTION);
 
   auto InitRes(const wgpu::Device &device, wgpu::TextureFormat format,
                const wgpu::BindGroupLayout &bindGroupLayout) -> void override;
 
-  auto UpdateRes(const wgpu::Device &device) const -> void override;
+  auto UpdateRes(RenderContext &context) const -> void override;
+
+  auto GetBatchGeometry() const -> std::optional<BatchGeometry> override;
+
+  auto Render(RenderEncoder &encoder) const -> void override;
 
-  auto Render(wgpu::RenderPassEncoder &renderPassEncoder) const
-      -> void override;
+  auto GetDrawState() const -> DrawState override;
 
   auto getOrigin() const -> glm::vec2;
 
@@ -54,6 +62,7 @@ public:
 
   auto setRadius(float radius) -> void;
 
+  // Segments drawn, as chosen from the requested resolution or the radius
   auto getResolution() const -> uint32_t;
 
   auto setResolution(uint32_t resolution) -> void;
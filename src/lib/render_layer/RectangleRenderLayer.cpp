@@ -8,10 +8,12 @@
 
 #include "Vertex.hpp"
 #include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
 
 namespace wglib::render_layers {
-std::optional<wgpu::RenderPipeline> RectangleRenderLayer::m_render_pipeline{
-    std::nullopt};
+namespace {
+constexpr uint32_t RECTANGLE_INDICES[6]{0, 1, 2, 3, 4, 5};
+}
 
 RectangleRenderLayer::RectangleRenderLayer(const glm::vec2 position,
                                            const glm::vec2 size,
@@ -20,135 +22,100 @@ RectangleRenderLayer::RectangleRenderLayer(const glm::vec2 position,
   calculateVertices();
 }
 
-// TODO use index buffers to make it more efficient
 auto RectangleRenderLayer::InitRes(const wgpu::Device &device,
                                    const wgpu::TextureFormat format,
                                    const wgpu::BindGroupLayout &bindGroupLayout)
     -> void {
   if (m_isInitialized)
     return;
-  constexpr wgpu::BufferDescriptor bufferDesc{
-      .usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst,
-      .size = sizeof(Vertex) * 6,
-      .mappedAtCreation = true,
-
-  };
-  m_vertex_buffer = device.CreateBuffer(&bufferDesc);
-
-  if (m_vertex_buffer.WriteMappedRange(0, m_vertices, sizeof(Vertex) * 6)
-          .status != wgpu::Status::Success) {
-    util::log("Failed to write to vertex buffer");
-    exit(0);
-  }
-  m_vertex_buffer.Unmap();
 
-  if (!m_render_pipeline)
-    initRenderPipeline(device, format, bindGroupLayout);
+  const auto vertexBufferLayout = Vertex::getVertexBufferLayout();
+  m_render_pipeline = PipelineCache::Get(device).GetRenderPipeline({
+      .shaderPath = "../src/shaders/default.wgsl",
+      .vertexEntryPoint = "vertexMain",
+      .vertexBuffers = {&vertexBufferLayout, 1},
+      .bindGroupLayouts = {&bindGroupLayout, 1},
+      .format = format,
+  });
+  m_transform = TransformBuffer::Get(device).Allocate();
+  updateTransform();
 
   m_isInitialized = true;
 }
 
 auto RectangleRenderLayer::calculateVertices() -> void {
-  const float x = m_position.x;
-  const float y = m_position.y;
-  const float w = m_size.x;
-  const float h = m_size.y;
-  m_vertices[0] = {{x, y}, m_color};         // Bottom-left
-  m_vertices[1] = {{x + w, y}, m_color};     // Bottom-right
-  m_vertices[2] = {{x + w, y + h}, m_color}; // Top-right
-  m_vertices[3] = {{x, y}, m_color};         // Bottom-left
-  m_vertices[4] = {{x + w, y + h}, m_color}; // Top-right
-  m_vertices[5] = {{x, y + h}, m_color};     // Top-left
+  // Unit quad around the origin, scaled to the size by the transform
+  m_vertices[0] = {{-0.5f, -0.5f}, m_color}; // Bottom-left
+  m_vertices[1] = {{0.5f, -0.5f}, m_color};  // Bottom-right
+  m_vertices[2] = {{0.5f, 0.5f}, m_color};   // Top-right
+  m_vertices[3] = {{-0.5f, -0.5f}, m_color}; // Bottom-left
+  m_vertices[4] = {{0.5f, 0.5f}, m_color};   // Top-right
+  m_vertices[5] = {{-0.5f, 0.5f}, m_color};  // Top-left
 }
 
-auto RectangleRenderLayer::updateVertexBuffer() -> void {
-  m_vertex_buffer_dirty = true;
+auto RectangleRenderLayer::updateTransform() -> void {
+  if (m_transform) {
+    m_transform.Set(ObjectTransform::Compose(m_position + m_size * 0.5f,
+                                             m_rotation, m_size));
+  }
 }
 
-auto RectangleRenderLayer::initRenderPipeline(
-    const wgpu::Device &device, wgpu::TextureFormat format,
-    const wgpu::BindGroupLayout &bindGroupLayout) -> void {
-  // Create render pipeline
-  const auto shaderCode = util::readFile("../src/shaders/default.wgsl");
-  wgpu::ShaderSourceWGSL wgsl{{.code = shaderCode.c_str()}};
-  wgpu::ShaderModuleDescriptor shaderModuleDescriptor{.nextInChain = &wgsl};
-  wgpu::ShaderModule shaderModule =
-      device.CreateShaderModule(&shaderModuleDescriptor);
-
-  wgpu::VertexAttribute attributes[2]{
-      {
-          .format = wgpu::VertexFormat::Float32x2,
-          .offset = 0,
-          .shaderLocation = 0,
-      },
-      {
-          .format = wgpu::VertexFormat::Float32x3,
-          .offset = sizeof(float) * 2,
-          .shaderLocation = 1,
-      },
-  };
-  wgpu::VertexBufferLayout vertexBufferLayout{
-      .stepMode = wgpu::VertexStepMode::Vertex,
-      .arrayStride = sizeof(Vertex),
-      .attributeCount = 2,
-
-      .attributes = attributes,
-  };
-  wgpu::ColorTargetState colorTargetState{.format = format};
-
-  wgpu::FragmentState fragmentState{
-      .module = shaderModule, .targetCount = 1, .targets = &colorTargetState};
-
-  // Create pipeline layout using the bind group layout
-  wgpu::PipelineLayoutDescriptor layoutDesc{
-      .bindGroupLayoutCount = 1, .bindGroupLayouts = &bindGroupLayout};
-  wgpu::PipelineLayout pipelineLayout =
-      device.CreatePipelineLayout(&layoutDesc);
-
-  wgpu::RenderPipelineDescriptor descriptor{
-      .layout = pipelineLayout,
-      .vertex =
-          {
-              .module = shaderModule,
-              .bufferCount = 1,
-              .buffers = &vertexBufferLayout,
-          },
-      .fragment = &fragmentState};
-  m_render_pipeline =
-      std::make_optional(device.CreateRenderPipeline(&descriptor));
-}
 
-auto RectangleRenderLayer::Render(
-    wgpu::RenderPassEncoder &renderPassEncoder) const -> void {
-  assert(m_render_pipeline.has_value() && "Render pipeline not initialized");
-  renderPassEncoder.SetPipeline(m_render_pipeline.value());
-  renderPassEncoder.SetVertexBuffer(0, m_vertex_buffer);
-  renderPassEncoder.Draw(6);
+auto RectangleRenderLayer::Render(RenderEncoder &encoder) const -> void {
+  assert(m_render_pipeline && "Render pipeline not initialized");
+  encoder.SetPipeline(m_render_pipeline);
+  encoder.SetVertexBuffer(0, m_vertex_buffer.Buffer(), m_vertex_buffer.Offset(),
+                          sizeof(m_vertices));
+  // The first instance selects the transform slot
+  encoder.Draw(6, 1, 0, m_transform.Index());
 }
 
-auto RectangleRenderLayer::UpdateRes(const wgpu::Device &device) const -> void {
+auto RectangleRenderLayer::UpdateRes(RenderContext &context) const -> void {
+  if (!m_vertex_buffer) {
+    m_vertex_buffer = BufferPool::Get(context.device).Allocate(sizeof(m_vertices));
+    m_vertex_buffer_dirty = true;
+    markDirty();
+  }
   if (m_vertex_buffer_dirty) {
-    auto queue = device.GetQueue();
-    queue.WriteBuffer(m_vertex_buffer, 0, m_vertices, sizeof(Vertex) * 6);
+    context.uploads.Write<Vertex>(m_vertex_buffer.Buffer(),
+                                  m_vertex_buffer.Offset(), m_vertices);
+    m_vertex_buffer_dirty = false;
   }
 }
 
+auto RectangleRenderLayer::GetDrawState() const -> DrawState {
+  return {.pipeline = m_render_pipeline.Get(),
+          .buffer = m_vertex_buffer.Buffer().Get()};
+}
+
+auto RectangleRenderLayer::GetBatchGeometry() const
+    -> std::optional<BatchGeometry> {
+  return BatchGeometry{.vertices = m_vertices,
+                       .indices = RECTANGLE_INDICES,
+                       .transform = m_transform.Index()};
+}
+
 auto RectangleRenderLayer::getPosition() const -> glm::vec2 {
   return m_position;
 }
 
 auto RectangleRenderLayer::setPosition(glm::vec2 pos) -> void {
   m_position = pos;
-  calculateVertices();
-  updateVertexBuffer();
+  updateTransform();
 }
 
 auto RectangleRenderLayer::getSize() const -> glm::vec2 { return m_size; }
 
 auto RectangleRenderLayer::setSize(glm::vec2 size) -> void {
   m_size = size;
-  calculateVertices();
-  updateVertexBuffer();
+  updateTransform();
+}
+
+auto RectangleRenderLayer::getRotation() const -> float { return m_rotation; }
+
+auto RectangleRenderLayer::setRotation(float radians) -> void {
+  m_rotation = radians;
+  updateTransform();
 }
 
 auto RectangleRenderLayer::getColor() const -> glm::vec3 { return m_color; }
@@ -5,21 +5,29 @@
 #pragma once
 #include "RenderLayer.hpp"
 #include "Vertex.hpp"
+#include "lib/BufferPool.hpp"
+#include "lib/TransformBuffer.hpp"
 #include "glm/vec2.hpp"
 #include "webgpu/webgpu_cpp.h"
 
 namespace wglib::render_layers {
 class RectangleRenderLayer : public RenderLayer {
 private:
-  static std::optional<wgpu::RenderPipeline> m_render_pipeline;
+  // Shared by all rectangles through the PipelineCache
+  wgpu::RenderPipeline m_render_pipeline;
 
   glm::vec2 m_size;
   glm::vec2 m_position;
+  float m_rotation{0.0f};
   glm::vec3 m_color;
 
-  wgpu::Buffer m_vertex_buffer;
-  bool m_vertex_buffer_dirty{false};
-  wgpu::Buffer m_index_buffer;
+  // Position, size and rotation live here; the mesh is a unit quad around
+  // the origin and only changes with the color
+  TransformHandle m_transform;
+
+  // Only created when the layer is drawn outside a batch
+  mutable BufferAllocation m_vertex_buffer;
+  mutable bool m_vertex_buffer_dirty{true};
 
   Vertex m_vertices[6];
 
@@ -27,10 +35,7 @@ private:
 
   auto calculateVertices() -> void;
 
-  auto updateVertexBuffer() -> void;
-
-  static auto initRenderPipeline(const wgpu::Device &, wgpu::TextureFormat,
-                                 const wgpu::BindGroupLayout &) -> void;
+  auto updateTransform() -> void;
 
 public:
   RectangleRenderLayer(glm::vec2 position, glm::vec2 size, glm::vec3 color);
@@ -38,10 +43,13 @@ public:
   auto InitRes(const wgpu::Device &device, wgpu::TextureFormat format,
                const wgpu::BindGroupLayout &bindGroupLayout) -> void override;
 
-  auto Render(wgpu::RenderPassEncoder &renderPassEncoder) const
-      -> void override;
+  auto Render(RenderEncoder &encoder) const -> void override;
+
+  auto GetDrawState() const -> DrawState override;
 
-  auto UpdateRes(const wgpu::Device &device) const -> void override;
+  auto UpdateRes(RenderContext &context) const -> void override;
+
+  auto GetBatchGeometry() const -> std::optional<BatchGeometry> override;
 
   auto getPosition() const -> glm::vec2;
 
@@ -51,6 +59,11 @@ public:
 
   auto setSize(glm::vec2 size) -> void;
 
+  // Radians around the rectangle's center
+  auto getRotation() const -> float;
+
+  auto setRotation(float radians) -> void;
+
   auto getColor() const -> glm::vec3;
   auto setColor(glm::vec3) -> void;
 
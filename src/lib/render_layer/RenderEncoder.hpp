@@ -0,0 +1,147 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib::render_layers {
+// Forwards draw commands to either a render pass or a render bundle encoder,
+// so a layer's Render can be replayed live or recorded into a bundle. State
+// that is already bound is not set again; SkippedStateChanges counts those.
+class RenderEncoder {
+public:
+  explicit RenderEncoder(wgpu::RenderPassEncoder &pass) : m_pass(&pass) {}
+  explicit RenderEncoder(wgpu::RenderBundleEncoder &bundle)
+      : m_bundle(&bundle) {}
+
+  // True while recording a bundle, which must not depend on per-frame state
+  auto IsBundle() const -> bool { return m_bundle != nullptr; }
+
+  // For pass-only commands (viewport, scissor); nullptr inside a bundle
+  auto Pass() const -> wgpu::RenderPassEncoder * { return m_pass; }
+
+  auto SetPipeline(const wgpu::RenderPipeline &pipeline) -> void {
+    if (m_state.pipeline == pipeline.Get()) {
+      ++m_skipped;
+      return;
+    }
+    m_state.pipeline = pipeline.Get();
+    ++m_issued;
+    forward([&](auto &e) { e.SetPipeline(pipeline); });
+  }
+
+  auto SetBindGroup(uint32_t groupIndex, const wgpu::BindGroup &group,
+                    size_t dynamicOffsetCount = 0,
+                    const uint32_t *dynamicOffsets = nullptr) -> void {
+    // Dynamic offsets are not tracked, those calls always go through
+    if (groupIndex < MAX_BIND_GROUPS) {
+      auto &bound = m_state.bindGroups[groupIndex];
+      if (dynamicOffsetCount == 0 and bound == group.Get()) {
+        ++m_skipped;
+        return;
+      }
+      bound = dynamicOffsetCount == 0 ? group.Get() : nullptr;
+    }
+    ++m_issued;
+    forward([&](auto &e) {
+      e.SetBindGroup(groupIndex, group, dynamicOffsetCount, dynamicOffsets);
+    });
+  }
+
+  auto SetVertexBuffer(uint32_t slot, const wgpu::Buffer &buffer,
+                       uint64_t offset = 0, uint64_t size = WGPU_WHOLE_SIZE)
+      -> void {
+    const BufferBinding binding{buffer.Get(), offset, size};
+    if (slot < MAX_VERTEX_BUFFERS) {
+      if (m_state.vertexBuffers[slot] == binding) {
+        ++m_skipped;
+        return;
+      }
+      m_state.vertexBuffers[slot] = binding;
+    }
+    ++m_issued;
+    forward([&](auto &e) { e.SetVertexBuffer(slot, buffer, offset, size); });
+  }
+
+  auto SetIndexBuffer(const wgpu::Buffer &buffer, wgpu::IndexFormat format,
+                      uint64_t offset = 0, uint64_t size = WGPU_WHOLE_SIZE)
+      -> void {
+    const BufferBinding binding{buffer.Get(), offset, size};
+    if (m_state.indexBuffer == binding and m_state.indexFormat == format) {
+      ++m_skipped;
+      return;
+    }
+    m_state.indexBuffer = binding;
+    m_state.indexFormat = format;
+    ++m_issued;
+    forward([&](auto &e) { e.SetIndexBuffer(buffer, format, offset, size); });
+  }
+
+  // Forget the bound state, e.g. after ExecuteBundles cleared it
+  auto ResetState() -> void { m_state = {}; }
+
+  auto SkippedStateChanges() const -> uint32_t { return m_skipped; }
+
+  auto IssuedStateChanges() const -> uint32_t { return m_issued; }
+
+  auto Draw(uint32_t vertexCount, uint32_t instanceCount = 1,
+            uint32_t firstVertex = 0, uint32_t firstInstance = 0) -> void {
+    forward([&](auto &e) {
+      e.Draw(vertexCount, instanceCount, firstVertex, firstInstance);
+    });
+  }
+
+  auto DrawIndexed(uint32_t indexCount, uint32_t instanceCount = 1,
+                   uint32_t firstIndex = 0, int32_t baseVertex = 0,
+                   uint32_t firstInstance = 0) -> void {
+    forward([&](auto &e) {
+      e.DrawIndexed(indexCount, instanceCount, firstIndex, baseVertex,
+                    firstInstance);
+    });
+  }
+
+  auto DrawIndirect(const wgpu::Buffer &indirectBuffer, uint64_t offset)
+      -> void {
+    forward([&](auto &e) { e.DrawIndirect(indirectBuffer, offset); });
+  }
+
+  auto DrawIndexedIndirect(const wgpu::Buffer &indirectBuffer,
+                           uint64_t offset) -> void {
+    forward([&](auto &e) { e.DrawIndexedIndirect(indirectBuffer, offset); });
+  }
+
+private:
+  constexpr static uint32_t MAX_BIND_GROUPS = 4;
+  constexpr static uint32_t MAX_VERTEX_BUFFERS = 8;
+
+  struct BufferBinding {
+    WGPUBuffer buffer{nullptr};
+    uint64_t offset{0};
+    uint64_t size{0};
+    auto operator==(const BufferBinding &) const -> bool = default;
+  };
+
+  struct BoundState {
+    WGPURenderPipeline pipeline{nullptr};
+    std::array<WGPUBindGroup, MAX_BIND_GROUPS> bindGroups{};
+    std::array<BufferBinding, MAX_VERTEX_BUFFERS> vertexBuffers{};
+    BufferBinding indexBuffer{};
+    wgpu::IndexFormat indexFormat{wgpu::IndexFormat::Undefined};
+  };
+
+  wgpu::RenderPassEncoder *m_pass{nullptr};
+  wgpu::RenderBundleEncoder *m_bundle{nullptr};
+  BoundState m_state{};
+  uint32_t m_skipped{0};
+  uint32_t m_issued{0};
+
+  template <typename F> auto forward(F &&command) -> void {
+    if (m_pass) {
+      command(*m_pass);
+    } else {
+      command(*m_bundle);
+    }
+  }
+};
+} // namespace wglib::render_layers
@@ -3,24 +3,114 @@
 //
 
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <vector>
 
+#include "RenderEncoder.hpp"
+#include "Vertex.hpp"
+#include "lib/UploadBelt.hpp"
 #include <webgpu/webgpu_cpp.h>
 
 namespace wglib::render_layers {
+// CPU-side triangle list of a layer drawn with default.wgsl. The renderer
+// merges consecutive layers that provide one into a single indexed draw.
+struct BatchGeometry {
+  std::span<const Vertex> vertices;
+  std::span<const uint32_t> indices;
+  // TransformBuffer slot applied to the vertices
+  uint32_t transform{0};
+};
+
+// Per-frame state handed to UpdateRes. Buffer writes go through uploads and
+// land before the frame's render pass.
+struct RenderContext {
+  const wgpu::Device &device;
+  UploadBelt &uploads;
+  uint32_t frameIndex;
+};
+
+// Handles a layer binds first in Render. Draws with the same order are sorted
+// by them so layers sharing a pipeline, bind group or buffer run back to back.
+struct DrawState {
+  const void *pipeline{nullptr};
+  const void *bindGroup{nullptr};
+  const void *buffer{nullptr};
+};
+
+// 64-bit render queue key: order (16 bits, most significant), then 16-bit
+// hashes of the pipeline, bind group and buffer handles. Hash collisions only
+// cost sorting quality, never correctness.
+inline auto MakeSortKey(int32_t order, const DrawState &state) -> uint64_t {
+  const auto hash16 = [](const void *handle) -> uint64_t {
+    const auto p = reinterpret_cast<uintptr_t>(handle);
+    return ((p >> 4) ^ (p >> 20) ^ (p >> 36)) & 0xFFFF;
+  };
+  const auto clamped = order < INT16_MIN   ? INT16_MIN
+                       : order > INT16_MAX ? INT16_MAX
+                                           : order;
+  const auto biased = static_cast<uint64_t>(clamped - INT16_MIN);
+  return biased << 48 | hash16(state.pipeline) << 32 |
+         hash16(state.bindGroup) << 16 | hash16(state.buffer);
+}
+
 class RenderLayer {
 public:
   RenderLayer() = default;
 
-  virtual auto Render(wgpu::RenderPassEncoder &renderPassEncoder) const
-      -> void = 0;
+  // Layers that return geometry here are batched by the renderer, which then
+  // skips their UpdateRes and Render for the frame.
+  virtual auto GetBatchGeometry() const -> std::optional<BatchGeometry> {
+    return std::nullopt;
+  }
+
+  // May be recorded into a render bundle for static layers, see SetStatic
+  virtual auto Render(RenderEncoder &encoder) const -> void = 0;
 
   virtual auto InitRes(const wgpu::Device &device, wgpu::TextureFormat format,
                        const wgpu::BindGroupLayout &bindGroupLayout)
       -> void = 0;
 
-  virtual auto UpdateRes(const wgpu::Device &device) const -> void = 0;
+  virtual auto UpdateRes(RenderContext &context) const -> void = 0;
+
+  // Used to sort draws of equal order; layers without one sort by order only
+  virtual auto GetDrawState() const -> DrawState { return {}; }
+
+  // Textures Render samples. The renderer's RenderGraph pass reads them, so
+  // passes writing them this frame are ordered before it.
+  virtual auto GetSampledTextures() const -> std::span<const wgpu::Texture> {
+    return {};
+  }
+
+  // A static layer is recorded into a render bundle together with the static
+  // layers next to it, and the bundle is replayed until one of them changes.
+  // Static layers are never batched.
+  auto SetStatic(bool isStatic) -> void { m_is_static = isStatic; }
+
+  auto IsStatic() const -> bool { return m_is_static; }
+
+  // Changes whenever the commands the layer encodes in Render would change.
+  // Unique across layers, so (address, revision) identifies a recording even
+  // if a destroyed layer's address is reused.
+  auto Revision() const -> uint64_t { return m_revision; }
 
   virtual ~RenderLayer();
+
+protected:
+  // Call when a setter or UpdateRes changes what Render encodes: pipeline,
+  // buffers, bind groups or draw counts. Data written into existing buffers
+  // does not need it.
+  auto markDirty() const -> void { m_revision = nextRevision(); }
+
+private:
+  static auto nextRevision() -> uint64_t {
+    static std::atomic<uint64_t> next{0};
+    return ++next;
+  }
+
+  bool m_is_static{false};
+  mutable uint64_t m_revision{nextRevision()};
 };
 } // namespace wglib::render_layers
@@ -0,0 +1,208 @@
+#include "ShapeRenderLayer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+#include "lib/PipelineCache.hpp"
+
+namespace wglib::render_layers {
+
+ShapeRenderLayer::ShapeRenderLayer(uint32_t capacity) {
+  m_instances.reserve(capacity);
+  m_id_of_slot.reserve(capacity);
+  m_slot_of_id.reserve(capacity);
+}
+
+auto ShapeRenderLayer::InitRes(const wgpu::Device &device,
+                               wgpu::TextureFormat format,
+                               const wgpu::BindGroupLayout &bindGroupLayout)
+    -> void {
+  // No per-vertex buffer: the quad corners come from the vertex index
+  const auto instanceBufferLayout =
+      ShapeInstance::Layout::Get(wgpu::VertexStepMode::Instance);
+
+  // Edges are anti-aliased through the alpha channel
+  const wgpu::BlendState blend{
+      .color = {.operation = wgpu::BlendOperation::Add,
+                .srcFactor = wgpu::BlendFactor::SrcAlpha,
+                .dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha},
+      .alpha = {.operation = wgpu::BlendOperation::Add,
+                .srcFactor = wgpu::BlendFactor::One,
+                .dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha},
+  };
+
+  m_render_pipeline = PipelineCache::Get(device).GetRenderPipeline({
+      .shaderPath = "../src/shaders/shapes.wgsl",
+      .vertexBuffers = {&instanceBufferLayout, 1},
+      .bindGroupLayouts = {&bindGroupLayout, 1},
+      .format = format,
+      .topology = wgpu::PrimitiveTopology::TriangleStrip,
+      .blend = &blend,
+  });
+}
+
+auto ShapeRenderLayer::UpdateRes(RenderContext &context) const -> void {
+  if (m_instances.empty())
+    return;
+
+  const auto required = sizeof(ShapeInstance) * m_instances.size();
+  if (!m_instance_buffer or m_instance_buffer.Size() < required) {
+    // Grow to the next power of two so adding shapes one by one stays cheap.
+    // The old block goes back to the pool once in-flight frames are done.
+    m_instance_buffer = BufferPool::Get(context.device)
+                            .Allocate(std::bit_ceil(std::max<uint64_t>(
+                                required, sizeof(ShapeInstance) *
+                                              m_instances.capacity())));
+    markDirty();
+    m_dirty_begin = 0;
+    m_dirty_end = static_cast<uint32_t>(m_instances.size());
+  }
+
+  if (m_dirty_begin < m_dirty_end) {
+    const auto end =
+        std::min(m_dirty_end, static_cast<uint32_t>(m_instances.size()));
+    if (m_dirty_begin < end) {
+      context.uploads.Write(
+          m_instance_buffer.Buffer(),
+          m_instance_buffer.Offset() + sizeof(ShapeInstance) * m_dirty_begin,
+          m_instances.data() + m_dirty_begin,
+          sizeof(ShapeInstance) * (end - m_dirty_begin));
+    }
+    m_dirty_begin = UINT32_MAX;
+    m_dirty_end = 0;
+  }
+}
+
+auto ShapeRenderLayer::Render(RenderEncoder &encoder) const -> void {
+  if (m_instances.empty() or !m_instance_buffer)
+    return;
+  encoder.SetPipeline(m_render_pipeline);
+  encoder.SetVertexBuffer(0, m_instance_buffer.Buffer(),
+                          m_instance_buffer.Offset(),
+                          sizeof(ShapeInstance) * m_instances.size());
+  encoder.Draw(4, static_cast<uint32_t>(m_instances.size()));
+}
+
+auto ShapeRenderLayer::GetDrawState() const -> DrawState {
+  return {.pipeline = m_render_pipeline.Get(),
+          .buffer = m_instance_buffer.Buffer().Get()};
+}
+
+auto ShapeRenderLayer::markSlotDirty(uint32_t slot) -> void {
+  m_dirty_begin = std::min(m_dirty_begin, slot);
+  m_dirty_end = std::max(m_dirty_end, slot + 1);
+}
+
+auto ShapeRenderLayer::instance(ShapeId id) -> ShapeInstance & {
+  assert(contains(id) && "Unknown shape id");
+  const auto slot = m_slot_of_id[id];
+  markSlotDirty(slot);
+  return m_instances[slot];
+}
+
+auto ShapeRenderLayer::addCircle(glm::vec2 center, float radius,
+                                 glm::vec3 color, float alpha) -> ShapeId {
+  return addRectangle(center - glm::vec2{radius}, glm::vec2{radius * 2.0f},
+                      color, radius, alpha);
+}
+
+auto ShapeRenderLayer::addRectangle(glm::vec2 position, glm::vec2 size,
+                                    glm::vec3 color, float cornerRadius,
+                                    float alpha) -> ShapeId {
+  ShapeId id;
+  if (not m_free_ids.empty()) {
+    id = m_free_ids.back();
+    m_free_ids.pop_back();
+  } else {
+    id = static_cast<ShapeId>(m_slot_of_id.size());
+    m_slot_of_id.push_back(INVALID_SLOT);
+  }
+
+  const auto slot = static_cast<uint32_t>(m_instances.size());
+  const auto halfSize = size * 0.5f;
+  m_instances.push_back({.center = position + halfSize,
+                         .halfSize = halfSize,
+                         .cornerRadius = cornerRadius,
+                         .color = Unorm8x4(color, alpha)});
+  m_id_of_slot.push_back(id);
+  m_slot_of_id[id] = slot;
+  markSlotDirty(slot);
+  // The instance count is part of the draw
+  markDirty();
+  return id;
+}
+
+auto ShapeRenderLayer::remove(ShapeId id) -> void {
+  assert(contains(id) && "Unknown shape id");
+  const auto slot = m_slot_of_id[id];
+  const auto last = static_cast<uint32_t>(m_instances.size() - 1);
+
+  // Swap the last instance into the hole so the array stays dense
+  if (slot != last) {
+    m_instances[slot] = m_instances[last];
+    m_id_of_slot[slot] = m_id_of_slot[last];
+    m_slot_of_id[m_id_of_slot[slot]] = slot;
+    markSlotDirty(slot);
+  }
+  m_instances.pop_back();
+  m_id_of_slot.pop_back();
+  m_slot_of_id[id] = INVALID_SLOT;
+  m_free_ids.push_back(id);
+  markDirty();
+}
+
+auto ShapeRenderLayer::clear() -> void {
+  m_instances.clear();
+  m_id_of_slot.clear();
+  m_slot_of_id.clear();
+  m_free_ids.clear();
+  m_dirty_begin = UINT32_MAX;
+  m_dirty_end = 0;
+  markDirty();
+}
+
+auto ShapeRenderLayer::contains(ShapeId id) const -> bool {
+  return id < m_slot_of_id.size() and m_slot_of_id[id] != INVALID_SLOT;
+}
+
+auto ShapeRenderLayer::size() const -> uint32_t {
+  return static_cast<uint32_t>(m_instances.size());
+}
+
+auto ShapeRenderLayer::getCenter(ShapeId id) const -> glm::vec2 {
+  assert(contains(id) && "Unknown shape id");
+  return m_instances[m_slot_of_id[id]].center;
+}
+
+auto ShapeRenderLayer::setCenter(ShapeId id, glm::vec2 center) -> void {
+  instance(id).center = center;
+}
+
+auto ShapeRenderLayer::getHalfSize(ShapeId id) const -> glm::vec2 {
+  assert(contains(id) && "Unknown shape id");
+  return m_instances[m_slot_of_id[id]].halfSize;
+}
+
+auto ShapeRenderLayer::setHalfSize(ShapeId id, glm::vec2 halfSize) -> void {
+  instance(id).halfSize = halfSize;
+}
+
+auto ShapeRenderLayer::setRadius(ShapeId id, float radius) -> void {
+  auto &shape = instance(id);
+  shape.halfSize = glm::vec2{radius};
+  shape.cornerRadius = radius;
+}
+
+auto ShapeRenderLayer::setCornerRadius(ShapeId id, float cornerRadius)
+    -> void {
+  instance(id).cornerRadius = cornerRadius;
+}
+
+auto ShapeRenderLayer::setColor(ShapeId id, glm::vec3 color, float alpha)
+    -> void {
+  instance(id).color = Unorm8x4(color, alpha);
+}
+
+ShapeRenderLayer::~ShapeRenderLayer() = default;
+} // namespace wglib::render_layers
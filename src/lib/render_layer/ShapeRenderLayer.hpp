@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RenderLayer.hpp"
+#include "VertexLayout.hpp"
+#include "lib/BufferPool.hpp"
+#include "glm/ext/vector_float2.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "webgpu/webgpu_cpp.h"
+
+namespace wglib::render_layers {
+// Per-instance record read by shapes.wgsl. A circle is a rounded rectangle
+// whose corner radius equals its half size.
+struct ShapeInstance {
+  glm::vec2 center;
+  glm::vec2 halfSize;
+  float cornerRadius;
+  Unorm8x4 color;
+
+  using Layout = VertexLayout<glm::vec2, glm::vec2, float, Unorm8x4>;
+};
+static_assert(sizeof(ShapeInstance) == 24);
+static_assert(sizeof(ShapeInstance) == ShapeInstance::Layout::STRIDE);
+
+// Draws any number of circles and rounded rectangles with one instanced draw.
+// Each shape is a quad shaded by a signed distance function, so moving one
+// only rewrites its instance record instead of retessellating it.
+class ShapeRenderLayer : public RenderLayer {
+public:
+  using ShapeId = uint32_t;
+  constexpr static auto DEFAULT_CAPACITY = 1024u;
+
+private:
+  constexpr static auto INVALID_SLOT = UINT32_MAX;
+
+  // Instances are kept dense for the draw; ids stay stable across removals
+  // through the id -> slot indirection
+  std::vector<ShapeInstance> m_instances;
+  std::vector<uint32_t> m_slot_of_id;
+  std::vector<ShapeId> m_id_of_slot;
+  std::vector<ShapeId> m_free_ids;
+
+  mutable BufferAllocation m_instance_buffer;
+  // Slots [begin, end) changed since the last upload
+  mutable uint32_t m_dirty_begin{UINT32_MAX};
+  mutable uint32_t m_dirty_end{0};
+
+  wgpu::RenderPipeline m_render_pipeline;
+
+  auto markSlotDirty(uint32_t slot) -> void;
+  auto instance(ShapeId id) -> ShapeInstance &;
+
+public:
+  explicit ShapeRenderLayer(uint32_t capacity = DEFAULT_CAPACITY);
+
+  auto InitRes(const wgpu::Device &device, wgpu::TextureFormat format,
+               const wgpu::BindGroupLayout &bindGroupLayout) -> void override;
+
+  auto UpdateRes(RenderContext &context) const -> void override;
+
+  auto Render(RenderEncoder &encoder) const -> void override;
+
+  auto GetDrawState() const -> DrawState override;
+
+  auto addCircle(glm::vec2 center, float radius, glm::vec3 color,
+                 float alpha = 1.0f) -> ShapeId;
+
+  // position is the top-left corner, like RectangleRenderLayer
+  auto addRectangle(glm::vec2 position, glm::vec2 size, glm::vec3 color,
+                    float cornerRadius = 0.0f, float alpha = 1.0f) -> ShapeId;
+
+  auto remove(ShapeId id) -> void;
+
+  auto clear() -> void;
+
+  auto contains(ShapeId id) const -> bool;
+
+  auto size() const -> uint32_t;
+
+  auto getCenter(ShapeId id) const -> glm::vec2;
+
+  auto setCenter(ShapeId id, glm::vec2 center) -> void;
+
+  auto getHalfSize(ShapeId id) const -> glm::vec2;
+
+  auto setHalfSize(ShapeId id, glm::vec2 halfSize) -> void;
+
+  auto setRadius(ShapeId id, float radius) -> void;
+
+  auto setCornerRadius(ShapeId id, float cornerRadius) -> void;
+
+  auto setColor(ShapeId id, glm::vec3 color, float alpha = 1.0f) -> void;
+
+  ~ShapeRenderLayer() override;
+};
+} // namespace wglib::render_layers
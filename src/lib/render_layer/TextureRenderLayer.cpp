@@ -1,5 +1,6 @@
 #include "TextureRenderLayer.hpp"
-#include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
+#include <algorithm>
 #include <vector>
 
 namespace wglib::render_layers {
@@ -19,15 +20,14 @@ TextureRenderLayer::~TextureRenderLayer() {
   }
 }
 
-void TextureRenderLayer::Render(
-    wgpu::RenderPassEncoder &renderPassEncoder) const {
+void TextureRenderLayer::Render(RenderEncoder &encoder) const {
   if (!m_pipeline || !m_bindGroup) {
     return;
   }
-  renderPassEncoder.SetPipeline(m_pipeline);
-  renderPassEncoder.SetBindGroup(0, m_bindGroup);
-  renderPassEncoder.SetVertexBuffer(0, m_vertexBuffer);
-  renderPassEncoder.Draw(4, 1, 0, 0);
+  encoder.SetPipeline(m_pipeline);
+  encoder.SetBindGroup(0, m_bindGroup);
+  encoder.SetVertexBuffer(0, m_vertexBuffer);
+  encoder.Draw(4, 1, 0, 0);
 }
 
 void TextureRenderLayer::InitRes(const wgpu::Device &device,
@@ -49,10 +49,6 @@ void TextureRenderLayer::InitRes(const wgpu::Device &device,
   device.GetQueue().WriteBuffer(m_vertexBuffer, 0, vertices.data(),
                                 bufferDesc.size);
 
-  // Shader
-  const auto shaderModule =
-      util::createShaderModuleFromFile("../src/shaders/texture.wgsl", device);
-
   // Bind group layout
   const wgpu::BindGroupLayoutEntry bglEntries[] = {
       {
@@ -74,20 +70,10 @@ void TextureRenderLayer::InitRes(const wgpu::Device &device,
       },
   };
 
-  const auto bglDesc = wgpu::BindGroupLayoutDescriptor{
-      .entryCount = std::size(bglEntries),
-      .entries = bglEntries,
-  };
-  m_bindGroupLayout = device.CreateBindGroupLayout(&bglDesc);
-
-  // Pipeline layout
-  const auto layoutDesc = wgpu::PipelineLayoutDescriptor{
-      .bindGroupLayoutCount = 1,
-      .bindGroupLayouts = &m_bindGroupLayout,
-  };
-  const auto pipelineLayout = device.CreatePipelineLayout(&layoutDesc);
+  auto &cache = PipelineCache::Get(device);
+  m_bindGroupLayout = cache.GetBindGroupLayout(bglEntries);
 
-  // Pipeline
+  // Pipeline, shared by all texture layers with the same target format
   const wgpu::VertexAttribute vertexAttrib{
       .format = wgpu::VertexFormat::Float32x2,
       .offset = 0,
@@ -100,59 +86,39 @@ void TextureRenderLayer::InitRes(const wgpu::Device &device,
       .attributes = &vertexAttrib,
   };
 
-  const wgpu::ColorTargetState colorTarget{
+  m_pipeline = cache.GetRenderPipeline({
+      .shaderPath = "../src/shaders/texture.wgsl",
+      .vertexEntryPoint = "vs_main",
+      .fragmentEntryPoint = "fs_main",
+      .vertexBuffers = {&vertexBufferLayout, 1},
+      .bindGroupLayouts = {&m_bindGroupLayout, 1},
       .format = format,
-  };
-
-  const wgpu::FragmentState fragmentState{
-      .module = shaderModule,
-      .entryPoint = "fs_main",
-      .targetCount = 1,
-      .targets = &colorTarget,
-  };
-
-  const auto pipelineDesc = wgpu::RenderPipelineDescriptor{
-      .layout = pipelineLayout,
-      .vertex =
-          {
-              .module = shaderModule,
-              .entryPoint = "vs_main",
-              .bufferCount = 1,
-              .buffers = &vertexBufferLayout,
-          },
-      .primitive =
-          {
-              .topology = wgpu::PrimitiveTopology::TriangleStrip,
-          },
-      .fragment = &fragmentState,
-  };
-
-  m_pipeline = device.CreateRenderPipeline(&pipelineDesc);
+      .topology = wgpu::PrimitiveTopology::TriangleStrip,
+  });
 }
 
-auto TextureRenderLayer::UpdateRes(const wgpu::Device &device) const -> void {
+auto TextureRenderLayer::UpdateRes(RenderContext &context) const -> void {
   if (!m_isDirty) {
     return;
   }
+  const auto &device = context.device;
 
   if (m_texture) {
-    bool needsBindGroup = false;
-
     if (!m_sampler) {
       const auto samplerDesc = wgpu::SamplerDescriptor{
           .magFilter = wgpu::FilterMode::Linear,
           .minFilter = wgpu::FilterMode::Linear,
       };
       m_sampler = device.CreateSampler(&samplerDesc);
-      needsBindGroup = true;
-    }
-
-    if (!m_textureView) {
-      m_textureView = m_texture->CreateView();
-      needsBindGroup = true;
     }
 
-    if (needsBindGroup) {
+    // Textures handed back and forth by a compute layer swap between the
+    // bind groups of the first round
+    auto cached = std::ranges::find(m_cachedBindGroups, m_texture->Get(),
+                                    &CachedBindGroup::texture);
+    if (cached == m_cachedBindGroups.end()) {
+      auto &cache = PipelineCache::Get(device);
+      m_textureView = cache.GetTextureView(*m_texture);
       const wgpu::BindGroupEntry bgEntries[] = {
           {
               .binding = 0,
@@ -163,21 +129,38 @@ auto TextureRenderLayer::UpdateRes(const wgpu::Device &device) const -> void {
               .sampler = m_sampler,
           },
       };
-
-      const auto bgDesc = wgpu::BindGroupDescriptor{
-          .layout = m_bindGroupLayout,
-          .entryCount = 2,
-          .entries = bgEntries,
-      };
-      m_bindGroup = device.CreateBindGroup(&bgDesc);
+      cached = m_cachedBindGroups.begin() + m_nextCachedBindGroup;
+      *cached = {m_texture->Get(),
+                 cache.GetBindGroup(m_bindGroupLayout, bgEntries)};
+      m_nextCachedBindGroup = (m_nextCachedBindGroup + 1) % CACHED_BIND_GROUPS;
+    }
+    const auto &bindGroup = cached->bindGroup;
+    if (bindGroup.Get() != m_bindGroup.Get()) {
+      m_bindGroup = bindGroup;
+      markDirty();
     }
-  } else {
+  } else if (m_bindGroup) {
     m_bindGroup = nullptr;
+    markDirty();
   }
 
   m_isDirty = false;
 }
 
+auto TextureRenderLayer::GetDrawState() const -> DrawState {
+  return {.pipeline = m_pipeline.Get(),
+          .bindGroup = m_bindGroup.Get(),
+          .buffer = m_vertexBuffer.Get()};
+}
+
+auto TextureRenderLayer::GetSampledTextures() const
+    -> std::span<const wgpu::Texture> {
+  if (m_texture) {
+    return {&*m_texture, 1};
+  }
+  return {};
+}
+
 void TextureRenderLayer::setTexture(wgpu::Texture texture) {
   m_texture = std::move(texture);
   m_isDirty = true;
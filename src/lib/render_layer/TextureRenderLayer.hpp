@@ -1,24 +1,32 @@
 #pragma once
 
 #include "RenderLayer.hpp"
+#include <array>
 #include <webgpu/webgpu_cpp.h>
 
 namespace wglib::render_layers {
 
 class TextureRenderLayer : public RenderLayer {
 public:
+  constexpr static size_t CACHED_BIND_GROUPS = 4;
+
   TextureRenderLayer(wgpu::Texture texture, float width, float height);
   TextureRenderLayer(float width, float height);
   ~TextureRenderLayer() override;
 
-  auto Render(wgpu::RenderPassEncoder &renderPassEncoder) const
-      -> void override;
+  auto Render(RenderEncoder &encoder) const -> void override;
 
   auto InitRes(const wgpu::Device &device, wgpu::TextureFormat format,
                const wgpu::BindGroupLayout &bindGroupLayout) -> void override;
 
-  auto UpdateRes(const wgpu::Device &device) const -> void override;
+  auto UpdateRes(RenderContext &context) const -> void override;
+
+  auto GetDrawState() const -> DrawState override;
 
+  auto GetSampledTextures() const -> std::span<const wgpu::Texture> override;
+
+  // Switching back to one of the last CACHED_BIND_GROUPS textures, e.g. the
+  // outputs of a compute::TextureRing, reuses its bind group
   void setTexture(wgpu::Texture texture);
   [[nodiscard]] auto getTexture() const -> std::optional<wgpu::Texture>;
 
@@ -35,6 +43,15 @@ private:
   mutable wgpu::TextureView m_textureView = nullptr;
   mutable wgpu::Sampler m_sampler = nullptr;
 
+  // The bind group's view keeps the texture alive, so its handle cannot be
+  // reused by another texture while the entry exists
+  struct CachedBindGroup {
+    WGPUTexture texture = nullptr;
+    wgpu::BindGroup bindGroup = nullptr;
+  };
+  mutable std::array<CachedBindGroup, CACHED_BIND_GROUPS> m_cachedBindGroups{};
+  mutable size_t m_nextCachedBindGroup = 0;
+
   mutable bool m_isDirty = true;
 };
 
@@ -1,5 +1,7 @@
 #include "TriangleRenderLayer.hpp"
 #include "lib/CoreUtil.hpp"
+#include "lib/PipelineCache.hpp"
+#include "lib/TransformBuffer.hpp"
 #include "lib/render_layer/Vertex.hpp"
 #include "webgpu/webgpu_cpp.h"
 
@@ -12,48 +14,50 @@ TriangleRenderLayer::TriangleRenderLayer(std::array<Vertex, 3> vertices) : m_ver
 auto TriangleRenderLayer::InitRes(const wgpu::Device &device, wgpu::TextureFormat format,
                                   const wgpu::BindGroupLayout &bindGroupLayout) -> void
 {
-    m_vertex_buffer =
-        util::createBuffer<Vertex, wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Vertex>(device, 3, true);
-    m_vertex_buffer.WriteMappedRange(0, &m_vertices, sizeof(m_vertices));
-    m_vertex_buffer.Unmap();
-    // TODO remove
-    util::log("Created Buffer and wrote to it");
-
-    auto shader_module = util::createShaderModuleFromFile("../src/shaders/default.wgsl", device);
-    auto vertex_buffer_layout = Vertex::getVertexBufferLayout();
-    auto colorTargetState = wgpu::ColorTargetState{.format = format};
-
-    auto fragmentState = wgpu::FragmentState{.module = shader_module, .targetCount = 1, .targets = &colorTargetState};
-
-    auto layoutDesc = wgpu::PipelineLayoutDescriptor{.bindGroupLayoutCount = 1, .bindGroupLayouts = &bindGroupLayout};
-    auto pipelineLayout = device.CreatePipelineLayout(&layoutDesc);
-
-    auto descriptor = wgpu::RenderPipelineDescriptor{.layout = pipelineLayout,
-                                                     .vertex =
-                                                         {
-                                                             .module = shader_module,
-                                                             .bufferCount = 1,
-                                                             .buffers = &vertex_buffer_layout,
-                                                         },
-                                                     .fragment = &fragmentState};
-    m_render_pipeline = device.CreateRenderPipeline(&descriptor);
+    // Every triangle shares the default pipeline instead of compiling its own
+    const auto vertexBufferLayout = Vertex::getVertexBufferLayout();
+    m_render_pipeline = PipelineCache::Get(device).GetRenderPipeline({
+        .shaderPath = "../src/shaders/default.wgsl",
+        .vertexEntryPoint = "vertexMain",
+        .vertexBuffers = {&vertexBufferLayout, 1},
+        .bindGroupLayouts = {&bindGroupLayout, 1},
+        .format = format,
+    });
 }
 
-auto TriangleRenderLayer::UpdateRes(const wgpu::Device &device) const -> void
+auto TriangleRenderLayer::UpdateRes(RenderContext &context) const -> void
 {
+    // Only needed when the triangle is drawn outside a batch
+    if (not m_vertex_buffer)
+    {
+        m_vertex_buffer = BufferPool::Get(context.device).Allocate(sizeof(m_vertices));
+        m_is_dirty = true;
+        markDirty();
+    }
     if (m_is_dirty)
     {
-        device.GetQueue().WriteBuffer(m_vertex_buffer, 0, &m_vertices, sizeof(m_vertices));
+        context.uploads.Write<Vertex>(m_vertex_buffer.Buffer(), m_vertex_buffer.Offset(), m_vertices);
         m_is_dirty = false;
     }
 }
 
-auto TriangleRenderLayer::Render(wgpu::RenderPassEncoder &encoder) const -> void
+auto TriangleRenderLayer::GetBatchGeometry() const -> std::optional<BatchGeometry>
 {
+    constexpr static uint32_t indices[3]{0, 1, 2};
+    return BatchGeometry{.vertices = m_vertices, .indices = indices};
+}
 
+auto TriangleRenderLayer::GetDrawState() const -> DrawState
+{
+    return {.pipeline = m_render_pipeline.Get(), .buffer = m_vertex_buffer.Buffer().Get()};
+}
+
+auto TriangleRenderLayer::Render(RenderEncoder &encoder) const -> void
+{
     encoder.SetPipeline(m_render_pipeline);
-    encoder.SetVertexBuffer(0, m_vertex_buffer);
-    encoder.Draw(3, 1);
+    encoder.SetVertexBuffer(0, m_vertex_buffer.Buffer(), m_vertex_buffer.Offset(), sizeof(m_vertices));
+    // Vertices are in screen space, drawn with the identity transform
+    encoder.Draw(3, 1, 0, TransformBuffer::IDENTITY);
 }
 
 } // namespace wglib::render_layers
@@ -1,5 +1,8 @@
 
 #pragma once
+#include <array>
+
+#include "lib/BufferPool.hpp"
 #include "lib/render_layer/RenderLayer.hpp"
 #include "lib/render_layer/Vertex.hpp"
 #include "webgpu/webgpu_cpp.h"
@@ -11,12 +14,16 @@ class TriangleRenderLayer : public RenderLayer
   public:
     TriangleRenderLayer(std::array<Vertex, 3> vertices);
 
-    auto Render(wgpu::RenderPassEncoder &renderPassEncoder) const -> void override;
+    auto Render(RenderEncoder &encoder) const -> void override;
 
     auto InitRes(const wgpu::Device &device, wgpu::TextureFormat format, const wgpu::BindGroupLayout &bindGroupLayout)
         -> void override;
 
-    auto UpdateRes(const wgpu::Device &device) const -> void override;
+    auto UpdateRes(RenderContext &context) const -> void override;
+
+    auto GetBatchGeometry() const -> std::optional<BatchGeometry> override;
+
+    auto GetDrawState() const -> DrawState override;
 
     auto getVertices() -> const std::array<Vertex, 3> &
     {
@@ -36,7 +43,7 @@ class TriangleRenderLayer : public RenderLayer
     }
 
   private:
-    wgpu::Buffer m_vertex_buffer;
+    mutable BufferAllocation m_vertex_buffer;
     wgpu::RenderPipeline m_render_pipeline;
 
     std::array<Vertex, 3> m_vertices;
@@ -4,37 +4,24 @@
 
 #pragma once
 
+#include "VertexLayout.hpp"
 #include "glm/ext/vector_float2.hpp"
-#include "glm/ext/vector_float3.hpp"
 #include "webgpu/webgpu_cpp.h"
 namespace wglib::render_layers
 {
+// 12 bytes: float position (screen space for triangles, local space for
+// meshes placed by a TransformBuffer slot) and an RGBA8 color
 struct Vertex
 {
     glm::vec2 position;
-    glm::vec3 color;
+    Unorm8x4 color;
+
+    using Layout = VertexLayout<glm::vec2, Unorm8x4>;
 
     constexpr static auto getVertexBufferLayout() noexcept
     {
-        constexpr static wgpu::VertexAttribute attributes[2]{
-            {
-                .format = wgpu::VertexFormat::Float32x2,
-                .offset = 0,
-                .shaderLocation = 0,
-            },
-            {
-                .format = wgpu::VertexFormat::Float32x3,
-                .offset = sizeof(float) * 2,
-                .shaderLocation = 1,
-            },
-        };
-        return wgpu::VertexBufferLayout{
-            .stepMode = wgpu::VertexStepMode::Vertex,
-            .arrayStride = sizeof(Vertex),
-            .attributeCount = 2,
-
-            .attributes = attributes,
-        };
+        return Layout::Get();
     }
 };
+static_assert(sizeof(Vertex) == Vertex::Layout::STRIDE);
 } // namespace wglib::render_layers
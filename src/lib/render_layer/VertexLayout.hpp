@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "glm/ext/vector_float2.hpp"
+#include "glm/ext/vector_float3.hpp"
+#include "glm/ext/vector_float4.hpp"
+#include "glm/gtc/packing.hpp"
+#include <webgpu/webgpu_cpp.h>
+
+namespace wglib::render_layers {
+// Packed attribute types. Each wraps the 32-bit word the GPU reads, so a
+// vertex struct built from them has no padding.
+
+// RGBA8, red in the lowest byte; read as vec4<f32> in [0, 1]
+struct Unorm8x4 {
+  uint32_t value{0};
+
+  constexpr Unorm8x4() = default;
+  Unorm8x4(glm::vec3 rgb, float alpha = 1.0f)
+      : value(glm::packUnorm4x8(glm::vec4(rgb, alpha))) {}
+  Unorm8x4(glm::vec4 rgba) : value(glm::packUnorm4x8(rgba)) {}
+
+  auto unpack() const -> glm::vec4 { return glm::unpackUnorm4x8(value); }
+};
+
+// Two components in [-1, 1] with 16 bits each; read as vec2<f32>
+struct Snorm16x2 {
+  uint32_t value{0};
+
+  constexpr Snorm16x2() = default;
+  Snorm16x2(glm::vec2 v) : value(glm::packSnorm2x16(v)) {}
+
+  auto unpack() const -> glm::vec2 { return glm::unpackSnorm2x16(value); }
+};
+
+// Two half floats; read as vec2<f32>. Exact to about 1/1000 of the value, so
+// fine for local-space meshes but not for screen positions.
+struct Float16x2 {
+  uint32_t value{0};
+
+  constexpr Float16x2() = default;
+  Float16x2(glm::vec2 v) : value(glm::packHalf2x16(v)) {}
+
+  auto unpack() const -> glm::vec2 { return glm::unpackHalf2x16(value); }
+};
+
+// Vertex format a member of type T is read with
+template <typename T> struct VertexFormatOf;
+template <> struct VertexFormatOf<float> {
+  constexpr static auto value = wgpu::VertexFormat::Float32;
+};
+template <> struct VertexFormatOf<glm::vec2> {
+  constexpr static auto value = wgpu::VertexFormat::Float32x2;
+};
+template <> struct VertexFormatOf<glm::vec3> {
+  constexpr static auto value = wgpu::VertexFormat::Float32x3;
+};
+template <> struct VertexFormatOf<glm::vec4> {
+  constexpr static auto value = wgpu::VertexFormat::Float32x4;
+};
+template <> struct VertexFormatOf<uint32_t> {
+  constexpr static auto value = wgpu::VertexFormat::Uint32;
+};
+template <> struct VertexFormatOf<Unorm8x4> {
+  constexpr static auto value = wgpu::VertexFormat::Unorm8x4;
+};
+template <> struct VertexFormatOf<Snorm16x2> {
+  constexpr static auto value = wgpu::VertexFormat::Snorm16x2;
+};
+template <> struct VertexFormatOf<Float16x2> {
+  constexpr static auto value = wgpu::VertexFormat::Float16x2;
+};
+
+template <typename T>
+concept VertexField = requires {
+  { VertexFormatOf<T>::value } -> std::convertible_to<wgpu::VertexFormat>;
+} and sizeof(T) % 4 == 0;
+
+// Vertex buffer layout of a struct whose members have the types Fields, in
+// declaration order and without padding. Check the struct against it with
+// static_assert(sizeof(S) == Layout::STRIDE).
+template <VertexField... Fields> struct VertexLayout {
+  constexpr static uint64_t STRIDE = (sizeof(Fields) + ...);
+  constexpr static size_t COUNT = sizeof...(Fields);
+
+  // Shader locations start at FirstLocation, so several buffers of one
+  // pipeline can be described without overlapping
+  template <uint32_t FirstLocation = 0>
+  constexpr static std::array<wgpu::VertexAttribute, COUNT> ATTRIBUTES = [] {
+    constexpr std::array<wgpu::VertexFormat, COUNT> formats{
+        VertexFormatOf<Fields>::value...};
+    constexpr std::array<uint64_t, COUNT> sizes{sizeof(Fields)...};
+    std::array<wgpu::VertexAttribute, COUNT> attributes{};
+    uint64_t offset = 0;
+    for (size_t i = 0; i < COUNT; ++i) {
+      attributes[i] = {
+          .format = formats[i],
+          .offset = offset,
+          .shaderLocation = FirstLocation + static_cast<uint32_t>(i),
+      };
+      offset += sizes[i];
+    }
+    return attributes;
+  }();
+
+  template <uint32_t FirstLocation = 0>
+  constexpr static auto
+  Get(wgpu::VertexStepMode stepMode = wgpu::VertexStepMode::Vertex)
+      -> wgpu::VertexBufferLayout {
+    return {
+        .stepMode = stepMode,
+        .arrayStride = STRIDE,
+        .attributeCount = COUNT,
+        .attributes = ATTRIBUTES<FirstLocation>.data(),
+    };
+  }
+};
+
+// Narrowest index format that addresses vertexCount vertices. Only used for
+// list topologies, so the strip restart value 0xFFFF is a valid index.
+constexpr auto IndexFormatFor(size_t vertexCount) -> wgpu::IndexFormat {
+  return vertexCount <= 0x10000 ? wgpu::IndexFormat::Uint16
+                                : wgpu::IndexFormat::Uint32;
+}
+
+constexpr auto IndexSize(wgpu::IndexFormat format) -> uint64_t {
+  return format == wgpu::IndexFormat::Uint16 ? sizeof(uint16_t)
+                                             : sizeof(uint32_t);
+}
+
+// Copies indices into 16-bit ones. An odd count is padded with a zero so the
+// bytes stay a multiple of the 4-byte copy alignment; draw with the original
+// count.
+inline auto NarrowIndices(std::span<const uint32_t> indices,
+                          std::vector<uint16_t> &out) -> void {
+  out.resize(indices.size() + indices.size() % 2);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    out[i] = static_cast<uint16_t>(indices[i]);
+  }
+  if (indices.size() % 2) {
+    out.back() = 0;
+  }
+}
+} // namespace wglib::render_layers
@@ -0,0 +1,311 @@
+#include "Scenarios.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numbers>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "GLFW/glfw3.h"
+#include "glm/common.hpp"
+#include "lib/CoreRenderer.hpp"
+#include "lib/CoreUtil.hpp"
+#include "lib/compute/ExampleLayers/ConwaysGameOfLife.hpp"
+#include "lib/compute/ExampleLayers/ExampleLayer.hpp"
+#include "lib/compute/ExampleLayers/ParticleSimulation.hpp"
+#include "lib/compute/Primitives/Compact.hpp"
+#include "lib/compute/Primitives/RadixSort.hpp"
+#include "lib/compute/Primitives/Reduce.hpp"
+#include "lib/compute/Primitives/Scan.hpp"
+#include "lib/compute/ReadbackLayer.hpp"
+#include "lib/render_layer/CircleRenderLayer.hpp"
+#include "lib/render_layer/RectangleRenderLayer.hpp"
+#include "lib/render_layer/ShapeRenderLayer.hpp"
+#include "lib/render_layer/TextureRenderLayer.hpp"
+#include "lib/render_layer/TriangleRenderLayer.hpp"
+#include "webgpu/webgpu_cpp.h"
+
+namespace wglib::scenarios
+{
+auto runSimpleTriangleExample(Engine &engine) -> void
+{
+    auto triangle = engine.CreateRenderLayer<render_layers::TriangleRenderLayer>(
+        std::array<render_layers::Vertex, 3>{render_layers::Vertex{
+                                                 .position = {1000.0f / 3, 1000 / 3 * 2},
+                                                 .color = glm::vec3{1, 0, 0},
+                                             },
+                                             render_layers::Vertex{
+                                                 .position = {1000.0f / 2, 1000 / 3},
+                                                 .color = glm::vec3{0, 1, 0},
+                                             },
+                                             render_layers::Vertex{
+                                                 .position = {1000.0f / 3 * 2, 1000 / 3 * 2},
+                                                 .color = glm::vec3{0, 0, 1},
+                                             }});
+
+    engine.OnUpdate([&engine, triangle](auto dt) { engine.Draw(triangle); });
+}
+
+auto runComputeAndDrawingExample(Engine &engine) -> void
+{
+    constexpr auto height = 1440uz;
+    constexpr auto width = 1440uz;
+
+    auto rect1 = engine.CreateRenderLayer<render_layers::RectangleRenderLayer>(
+        glm::vec2{10, 10}, glm::vec2{300, 300}, glm::vec3{0.0f, 1.0f, 0.0f});
+
+    auto circle = engine.CreateRenderLayer<render_layers::CircleRenderLayer>(glm::vec2{250, 250}, 50.0f,
+                                                                             glm::vec3{0.0f, 0.0f, 1.0f});
+
+    auto compute = engine.InitComputeLayer<compute::ExampleLayer<50000>>(static_cast<float>(std::numbers::pi));
+
+    // Suspends until the readback completes instead of registering a callback
+    [](Engine &engine, compute::ComputeEngine::ComputeLayerHandle<std::optional<compute::ReadbackView<float>>> layer)
+        -> compute::Workflow {
+        const auto res = co_await engine.Compute(layer);
+        if (not res)
+        {
+            util::log("failed to get items");
+            co_return;
+        }
+        // The staging buffer returns to the layer when res goes out of scope
+        for (const auto &item : res->Span() | std::ranges::views::take(10))
+        {
+            util::log("Item: {}", item);
+        }
+    }(engine, compute);
+
+    engine.OnUpdate([&engine, rect1, circle, compute, velocity = glm::vec2{50}](const double s) mutable {
+        engine.Draw(rect1);
+        if (rect1->getPosition().x + rect1->getSize().x > width or rect1->getPosition().x < 0)
+        {
+            velocity.x *= -1;
+        }
+        if (rect1->getPosition().y + rect1->getSize().y > height or rect1->getPosition().y < 0)
+        {
+            velocity.y *= -1;
+        }
+
+        rect1->setPosition(rect1->getPosition() + velocity * static_cast<float>(s));
+
+        // Drawn above the rectangle it overlaps
+        engine.Draw(circle, 1);
+        auto radius = circle->getRadius() - circle->getRadius() * s;
+        if (radius <= 10)
+            radius = 100;
+        circle->setRadius(radius);
+
+        auto time = engine.GetTime();
+        auto rotating_color = glm::vec3((sin(time * 1.0f) + 1.0f) * 0.5f, // Red channel
+                                        (sin(time * 1.3f) + 1.0f) * 0.5f, // Green channel
+                                        (sin(time * 1.7f) + 1.0f) * 0.5f  // Blue channel
+        );
+        circle->setColor(rotating_color);
+    });
+}
+
+auto runConwaysGameOfLife(Engine &engine) -> void
+{
+    struct State
+    {
+        compute::ComputeEngine::ComputeLayerHandle<const wgpu::Texture &> compute;
+        Renderer::Ref<render_layers::TextureRenderLayer> textureRenderLayer;
+    };
+
+    // Three outputs: one drawn, one being written, one spare for the frame in
+    // flight, so a generation is pushed every tick without waiting for the last
+    auto state = std::make_shared<State>(
+        engine.InitComputeLayer<compute::ConwaysGameOfLifeComputeLayer>(glm::vec2{2560, 1440}, 3),
+        engine.CreateRenderLayer<render_layers::TextureRenderLayer>(2560, 1440));
+
+    // Simulate at a fixed 120 Hz independent of the 60 Hz display
+    engine.SetTickRate(120.0);
+    engine.SetTargetFPS(60.0);
+
+    engine.OnFixedUpdate([&engine, state](double) {
+        engine.PushComputeLayer(state->compute, [s = state.get()](wgpu::Texture texture) {
+            s->textureRenderLayer->setTexture(texture);
+        });
+    });
+
+    engine.OnUpdate([&engine, state](auto) { engine.Draw(state->textureRenderLayer); });
+}
+
+auto runParticleSimulation(Engine &engine) -> void
+{
+    struct State
+    {
+        compute::ComputeEngine::ComputeLayerHandle<std::optional<wgpu::Texture>> compute;
+        Renderer::Ref<render_layers::TextureRenderLayer> textureRenderLayer;
+    };
+
+    // Drawn from a ring of three textures, so a step is pushed every frame
+    // while the previous one is still being drawn
+    auto state = std::make_shared<State>(
+        engine.InitComputeLayer<compute::ParticleSimulationLayer>(10000, glm::vec2{2560, 1440}, 2,
+                                                                  glm::vec4{0, 1, 1, 1}, glm::vec2{500, 500}, 100,
+                                                                  0.016, 500, 0.98, 2000, 50, 3),
+        engine.CreateRenderLayer<render_layers::TextureRenderLayer>(2560, 1440));
+
+    engine.SetTargetFPS(120.0);
+
+    engine.OnUpdate([&engine, state](auto) {
+        engine.PushComputeLayer(state->compute, [s = state.get()](std::optional<wgpu::Texture> res) {
+            if (not res)
+            {
+                util::log("Failed to get results");
+                return;
+            }
+            s->textureRenderLayer->setTexture(std::move(*res));
+        });
+
+        engine.Draw(state->textureRenderLayer);
+    });
+}
+
+auto refactorTest(Engine &engine) -> void
+{
+    auto circleRenderLayer = engine.CreateRenderLayer<render_layers::CircleRenderLayer>(
+        glm::vec2{250, 250}, 50.0f, glm::vec3{0.0f, 0.0f, 1.0f});
+    engine.OnUpdate([&engine, circleRenderLayer](auto dt) { engine.Draw(circleRenderLayer); });
+}
+
+auto interactionTest(Engine &engine) -> void
+{
+    using Circle = Renderer::Ref<render_layers::CircleRenderLayer>;
+
+    // Circles are added to the scene once and removed when they leave the screen
+    engine.OnUpdate([&engine, circles = std::vector<std::pair<Circle, Scene::Id>>{}, frame = 0u](auto delta) mutable {
+        auto pressed = false;
+        auto xPos = 0.0;
+        auto yPos = 0.0;
+        if (auto *window = engine.GetWindow())
+        {
+            pressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT);
+            glfwGetCursorPos(window, &xPos, &yPos);
+        }
+        else
+        {
+            // Headless: hold the button down and sweep the cursor along the top
+            pressed = true;
+            xPos = static_cast<double>((frame * 37) % 500);
+            yPos = 50.0;
+        }
+        ++frame;
+
+        if (pressed)
+        {
+            auto circle = engine.CreateRenderLayer<render_layers::CircleRenderLayer>(glm::vec2{xPos, yPos}, 50.0f,
+                                                                                     glm::vec3{0.0f, 0.0f, 1.0f});
+            circles.emplace_back(circle, engine.GetScene().Add(circle));
+        }
+
+        std::erase_if(circles, [&engine](auto &entry) {
+            auto &[layer, id] = entry;
+            layer->setOrigin(layer->getOrigin() + glm::vec2{0, 1});
+            if (layer->getOrigin().y + layer->getRadius() > 500)
+            {
+                engine.GetScene().Remove(id);
+                return true;
+            }
+            return false;
+        });
+    });
+}
+
+auto runShapesExample(Engine &engine) -> void
+{
+    constexpr auto SHAPE_COUNT = 100'000u;
+    constexpr auto MOVED_PER_FRAME = 1'000u;
+    const glm::vec2 size{1920, 1080};
+
+    auto shapes = engine.CreateRenderLayer<render_layers::ShapeRenderLayer>(SHAPE_COUNT);
+    // Moving shapes only rewrites instance data, so the recorded bundle stays valid
+    shapes->SetStatic(true);
+    engine.GetScene().Add(shapes);
+    std::vector<glm::vec2> velocities;
+    velocities.reserve(SHAPE_COUNT);
+
+    // Deterministic layout so benchmark runs are comparable
+    for (auto i : std::views::iota(0u, SHAPE_COUNT))
+    {
+        const auto t = static_cast<float>(i);
+        const glm::vec2 position{std::fmod(t * 7.31f, size.x), std::fmod(t * 3.17f, size.y)};
+        const glm::vec3 color{std::fmod(t * 0.013f, 1.0f), std::fmod(t * 0.007f, 1.0f), 0.8f};
+        if (i % 2 == 0)
+        {
+            shapes->addCircle(position, 2.0f + static_cast<float>(i % 5), color);
+        }
+        else
+        {
+            shapes->addRectangle(position, {6.0f + static_cast<float>(i % 7), 4.0f}, color, 1.5f);
+        }
+        velocities.push_back({std::cos(t), std::sin(t)});
+    }
+
+    engine.OnUpdate([shapes, size, velocities = std::move(velocities), next = 0u](auto) mutable {
+        // Only the moved shapes are re-uploaded
+        for (auto i = 0u; i < MOVED_PER_FRAME; ++i, next = (next + 1) % SHAPE_COUNT)
+        {
+            auto center = shapes->getCenter(next) + velocities[next] * 4.0f;
+            center = glm::mod(center + size, size);
+            shapes->setCenter(next, center);
+        }
+    });
+}
+
+auto runParallelPrimitives(Engine &engine) -> void
+{
+    // Three levels of tiles for the reduction and the scans
+    constexpr auto count = 3'000'000u;
+    std::vector<uint32_t> values(count);
+    std::vector<uint32_t> flags(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        values[i] = (i * 2654435761u) >> 24;
+        // Any non-zero flag keeps a value
+        flags[i] = values[i] % 3 == 0 ? values[i] % 5 + 1 : 0;
+    }
+
+    using Readback = compute::ReadbackLayer<uint32_t>;
+    using View = std::optional<compute::ReadbackView<uint32_t>>;
+    auto check = [](std::string_view name, std::vector<uint32_t> expected) {
+        return [name, expected = std::move(expected)](View result) {
+            const auto matches = result and result->size() >= expected.size() and
+                                 std::ranges::equal(result->Span().first(expected.size()), expected);
+            util::log("{} {} the CPU reference", name, matches ? "matches" : "does not match");
+        };
+    };
+
+    // Every primitive feeds a readback layer, all in one submission
+    compute::ComputeGraph graph;
+    auto reduce = graph.Add(engine.InitComputeLayer<compute::Reduce<uint32_t>>(values));
+    auto reduceReadback = graph.Add(engine.InitComputeLayer<Readback>());
+    graph.Connect(reduce, reduceReadback);
+    graph.OnComplete(reduceReadback, check("Reduce", {compute::ReduceReference<uint32_t>(values)}));
+
+    auto scan = graph.Add(engine.InitComputeLayer<compute::Scan<uint32_t>>(values, compute::ScanKind::Exclusive));
+    auto scanReadback = graph.Add(engine.InitComputeLayer<Readback>());
+    graph.Connect(scan, scanReadback);
+    graph.OnComplete(scanReadback, check("Exclusive scan", compute::ExclusiveScanReference<uint32_t>(values)));
+
+    auto compact = graph.Add(engine.InitComputeLayer<compute::Compact<uint32_t>>(values, flags));
+    auto compactReadback = graph.Add(engine.InitComputeLayer<Readback>());
+    graph.Connect(compact, compactReadback);
+    graph.OnComplete(compactReadback, check("Compact", compute::CompactReference<uint32_t>(values, flags)));
+
+    // Keys only; wglib_bench --sort checks sorting key-value pairs
+    auto sortedValues = values;
+    std::ranges::sort(sortedValues);
+    auto sort = graph.Add(engine.InitComputeLayer<compute::RadixSortLayer>(values));
+    auto sortReadback = graph.Add(engine.InitComputeLayer<Readback>());
+    graph.Connect(sort, sortReadback);
+    graph.OnComplete(sortReadback, check("Radix sort", std::move(sortedValues)));
+
+    engine.PushComputeGraph(graph);
+}
+} // namespace wglib::scenarios
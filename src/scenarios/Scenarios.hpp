@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <string_view>
+
+#include "glm/ext/vector_float2.hpp"
+#include "lib/CoreEngine.hpp"
+
+// Demo scenes shared by the wglib example app and the wglib_bench target.
+// Each setup function registers its layers and callbacks on an engine the
+// caller created with the scenario's size; the caller then calls Start().
+namespace wglib::scenarios
+{
+auto runSimpleTriangleExample(Engine &engine) -> void;
+auto runComputeAndDrawingExample(Engine &engine) -> void;
+auto runConwaysGameOfLife(Engine &engine) -> void;
+auto runParticleSimulation(Engine &engine) -> void;
+auto refactorTest(Engine &engine) -> void;
+// Spawns circles under the mouse. Without a window the cursor is simulated.
+auto interactionTest(Engine &engine) -> void;
+// 100k instanced circles and rounded rectangles, a thousand of them move each frame
+auto runShapesExample(Engine &engine) -> void;
+// Runs Reduce, Scan and Compact once and logs whether they match the CPU references
+auto runParallelPrimitives(Engine &engine) -> void;
+
+struct Scenario
+{
+    std::string_view name;
+    std::string_view title;
+    glm::vec2 size;
+    auto (*setup)(Engine &) -> void;
+};
+
+inline const std::array SCENARIOS{
+    Scenario{"particles", "title", {2560, 1440}, runParticleSimulation},
+    Scenario{"refactor", "Game", {500, 500}, refactorTest},
+    Scenario{"conway", "title", {2560, 1440}, runConwaysGameOfLife},
+    Scenario{"triangle", "triangle", {1000, 1000}, runSimpleTriangleExample},
+    Scenario{"interaction", "Game", {500, 500}, interactionTest},
+    Scenario{"compute_and_drawing", "title", {1440, 1440}, runComputeAndDrawingExample},
+    Scenario{"shapes", "shapes", {1920, 1080}, runShapesExample},
+    Scenario{"primitives", "primitives", {500, 500}, runParallelPrimitives},
+};
+
+inline auto findScenario(std::string_view name) -> std::optional<Scenario>
+{
+    for (const auto &scenario : SCENARIOS)
+    {
+        if (scenario.name == name)
+        {
+            return scenario;
+        }
+    }
+    return std::nullopt;
+}
+} // namespace wglib::scenarios
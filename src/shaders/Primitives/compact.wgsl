@@ -0,0 +1,28 @@
+// Scatter of a stream compaction: every element whose flag is not 0 moves to
+// the position the exclusive scan of the flags gives it, and the last element
+// writes how many were kept. The scan counts every non-zero flag as 1.
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> values: array<T>;
+@group(0) @binding(2) var<storage, read> flags: array<u32>;
+@group(0) @binding(3) var<storage, read> positions: array<u32>;
+@group(0) @binding(4) var<storage, read_write> compacted: array<T>;
+@group(0) @binding(5) var<storage, read_write> kept: array<u32>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(local_invocation_id) local_id: vec3<u32>,
+        @builtin(workgroup_id) group_id: vec3<u32>) {
+    let base = group_id.x * TILE_SIZE + local_id.x;
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        let index = base + i * WORKGROUP_SIZE;
+        if (index >= params.count) {
+            break;
+        }
+        if (flags[index] != 0u) {
+            compacted[positions[index]] = values[index];
+        }
+        if (index == params.count - 1u) {
+            kept[0] = positions[index] + select(0u, 1u, flags[index] != 0u);
+        }
+    }
+}
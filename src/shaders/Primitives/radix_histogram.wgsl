@@ -0,0 +1,40 @@
+// First step of a radix sort pass: counts how many keys of every tile have
+// each digit. The counts are stored digit by digit, so an exclusive scan of
+// them gives every tile the first position of each of its digits. RADIX and
+// the tile constants come from the prelude of RadixSortLayer.
+
+struct SortParams {
+    count: u32,
+    shift: u32,
+    tiles: u32,
+};
+
+@group(0) @binding(0) var<uniform> params: SortParams;
+@group(0) @binding(1) var<storage, read> keys: array<u32>;
+@group(0) @binding(2) var<storage, read_write> histograms: array<u32>;
+
+var<workgroup> bins: array<atomic<u32>, RADIX>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(local_invocation_id) local_id: vec3<u32>,
+        @builtin(workgroup_id) group_id: vec3<u32>) {
+    let lane = local_id.x;
+    if (lane < RADIX) {
+        atomicStore(&bins[lane], 0u);
+    }
+    workgroupBarrier();
+
+    let base = group_id.x * TILE_SIZE + lane;
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        let index = base + i * WORKGROUP_SIZE;
+        if (index < params.count) {
+            let digit = (keys[index] >> params.shift) & (RADIX - 1u);
+            atomicAdd(&bins[digit], 1u);
+        }
+    }
+    workgroupBarrier();
+
+    if (lane < RADIX) {
+        histograms[lane * params.tiles + group_id.x] = atomicLoad(&bins[lane]);
+    }
+}
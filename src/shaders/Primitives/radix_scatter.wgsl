@@ -0,0 +1,115 @@
+// Second step of a radix sort pass: moves every key, and its value in
+// scatter_pairs, to the scanned position of its digit in its tile plus its
+// rank among the keys of the tile with the same digit. Ranks follow the input
+// order, which keeps every pass stable. scatter_keys never touches the value
+// bindings, so its derived layout leaves them out. RADIX and the tile
+// constants come from the prelude of RadixSortLayer.
+
+struct SortParams {
+    count: u32,
+    shift: u32,
+    tiles: u32,
+};
+
+// A 16-bit counter per digit, two to a word
+const COUNTER_WORDS: u32 = RADIX / 2u;
+
+@group(0) @binding(0) var<uniform> params: SortParams;
+@group(0) @binding(1) var<storage, read> keys_in: array<u32>;
+@group(0) @binding(2) var<storage, read_write> keys_out: array<u32>;
+@group(0) @binding(3) var<storage, read> values_in: array<u32>;
+@group(0) @binding(4) var<storage, read_write> values_out: array<u32>;
+@group(0) @binding(5) var<storage, read> digit_offsets: array<u32>;
+
+// Per lane, how many of its keys have each digit
+var<workgroup> lane_counts: array<array<u32, COUNTER_WORDS>, WORKGROUP_SIZE>;
+
+// The keys of one lane and where they go; only those below params.count are
+// meaningful
+struct LaneKeys {
+    keys: array<u32, ITEMS_PER_THREAD>,
+    positions: array<u32, ITEMS_PER_THREAD>,
+}
+
+// Every lane ranks ITEMS_PER_THREAD consecutive keys starting at
+// lane_base(lane, tile)
+fn lane_base(lane: u32, tile: u32) -> u32 {
+    return tile * TILE_SIZE + lane * ITEMS_PER_THREAD;
+}
+
+fn rank_keys(lane: u32, tile: u32) -> LaneKeys {
+    let base = lane_base(lane, tile);
+
+    var items: array<u32, ITEMS_PER_THREAD>;
+    var digits: array<u32, ITEMS_PER_THREAD>;
+    var counts: array<u32, COUNTER_WORDS>;
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        if (base + i < params.count) {
+            items[i] = keys_in[base + i];
+            digits[i] = (items[i] >> params.shift) & (RADIX - 1u);
+            counts[digits[i] / 2u] += 1u << ((digits[i] % 2u) * 16u);
+        }
+    }
+    lane_counts[lane] = counts;
+    workgroupBarrier();
+
+    // Inclusive Hillis-Steele scan of the packed counters; a tile holds at
+    // most TILE_SIZE keys, so no counter carries into the next
+    for (var offset = 1u; offset < WORKGROUP_SIZE; offset <<= 1u) {
+        var value = lane_counts[lane];
+        if (lane >= offset) {
+            let before = lane_counts[lane - offset];
+            for (var word = 0u; word < COUNTER_WORDS; word++) {
+                value[word] += before[word];
+            }
+        }
+        workgroupBarrier();
+        lane_counts[lane] = value;
+        workgroupBarrier();
+    }
+
+    // Keys with each digit in the lanes before this one
+    var ranks: array<u32, COUNTER_WORDS>;
+    if (lane > 0u) {
+        ranks = lane_counts[lane - 1u];
+    }
+    var result: LaneKeys;
+    result.keys = items;
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        if (base + i < params.count) {
+            let digit = digits[i];
+            let word = digit / 2u;
+            let bit = (digit % 2u) * 16u;
+            let rank = (ranks[word] >> bit) & 0xffffu;
+            ranks[word] += 1u << bit;
+            result.positions[i] = digit_offsets[digit * params.tiles + tile] + rank;
+        }
+    }
+    return result;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn scatter_keys(@builtin(local_invocation_id) local_id: vec3<u32>,
+                @builtin(workgroup_id) group_id: vec3<u32>) {
+    let base = lane_base(local_id.x, group_id.x);
+    let lane = rank_keys(local_id.x, group_id.x);
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        if (base + i < params.count) {
+            keys_out[lane.positions[i]] = lane.keys[i];
+        }
+    }
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn scatter_pairs(@builtin(local_invocation_id) local_id: vec3<u32>,
+                 @builtin(workgroup_id) group_id: vec3<u32>) {
+    let base = lane_base(local_id.x, group_id.x);
+    let lane = rank_keys(local_id.x, group_id.x);
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        let index = base + i;
+        if (index < params.count) {
+            keys_out[lane.positions[i]] = lane.keys[i];
+            values_out[lane.positions[i]] = values_in[index];
+        }
+    }
+}
@@ -0,0 +1,40 @@
+// One level of a multi-level reduction: every workgroup combines a tile of
+// TILE_SIZE elements into one value of the next level. T, identity, combine,
+// Params and the tile constants come from the prelude of the layer.
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> data_in: array<T>;
+@group(0) @binding(2) var<storage, read_write> tile_sums: array<T>;
+
+var<workgroup> partials: array<T, WORKGROUP_SIZE>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(local_invocation_id) local_id: vec3<u32>,
+        @builtin(workgroup_id) group_id: vec3<u32>) {
+    let lane = local_id.x;
+    let base = group_id.x * TILE_SIZE + lane;
+
+    // Strided by the workgroup size so neighbouring lanes load neighbouring
+    // elements
+    var acc = identity();
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        let index = base + i * WORKGROUP_SIZE;
+        if (index < params.count) {
+            acc = combine(acc, data_in[index]);
+        }
+    }
+    partials[lane] = acc;
+    workgroupBarrier();
+
+    // Tree reduction in shared memory
+    for (var stride = WORKGROUP_SIZE / 2u; stride > 0u; stride >>= 1u) {
+        if (lane < stride) {
+            partials[lane] = combine(partials[lane], partials[lane + stride]);
+        }
+        workgroupBarrier();
+    }
+
+    if (lane == 0u) {
+        tile_sums[group_id.x] = partials[0];
+    }
+}
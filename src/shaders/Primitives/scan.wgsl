@@ -0,0 +1,63 @@
+// One level of a multi-level scan: every workgroup scans a tile of TILE_SIZE
+// elements on its own and writes the tile's total for the next level, whose
+// scan scan_add.wgsl then adds back. T, identity, combine, Params and the
+// tile constants come from the prelude of the layer.
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> data_in: array<T>;
+@group(0) @binding(2) var<storage, read_write> data_out: array<T>;
+@group(0) @binding(3) var<storage, read_write> tile_sums: array<T>;
+
+var<workgroup> lane_sums: array<T, WORKGROUP_SIZE>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(local_invocation_id) local_id: vec3<u32>,
+        @builtin(workgroup_id) group_id: vec3<u32>) {
+    let lane = local_id.x;
+    // Every lane scans ITEMS_PER_THREAD consecutive elements
+    let base = group_id.x * TILE_SIZE + lane * ITEMS_PER_THREAD;
+
+    var items: array<T, ITEMS_PER_THREAD>;
+    var total = identity();
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        var item = identity();
+        if (base + i < params.count) {
+            item = data_in[base + i];
+            if (params.flags != 0u) {
+                item = select(T(0), T(1), item != T(0));
+            }
+        }
+        items[i] = item;
+        total = combine(total, item);
+    }
+    lane_sums[lane] = total;
+    workgroupBarrier();
+
+    // Inclusive Hillis-Steele scan of the lane totals in shared memory
+    for (var offset = 1u; offset < WORKGROUP_SIZE; offset <<= 1u) {
+        var value = lane_sums[lane];
+        if (lane >= offset) {
+            value = combine(lane_sums[lane - offset], value);
+        }
+        workgroupBarrier();
+        lane_sums[lane] = value;
+        workgroupBarrier();
+    }
+
+    var acc = identity();
+    if (lane > 0u) {
+        acc = lane_sums[lane - 1u];
+    }
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        let index = base + i;
+        let before = acc;
+        acc = combine(acc, items[i]);
+        if (index < params.count) {
+            data_out[index] = select(acc, before, params.exclusive != 0u);
+        }
+    }
+
+    if (lane == WORKGROUP_SIZE - 1u) {
+        tile_sums[group_id.x] = lane_sums[lane];
+    }
+}
@@ -0,0 +1,22 @@
+// Second half of a scan level: combines the scanned totals of the tiles before
+// each tile into its elements. Dispatched once per tile after the first.
+
+@group(0) @binding(0) var<uniform> params: Params;
+@group(0) @binding(1) var<storage, read> tile_offsets: array<T>;
+@group(0) @binding(2) var<storage, read_write> data: array<T>;
+
+@compute @workgroup_size(WORKGROUP_SIZE)
+fn main(@builtin(local_invocation_id) local_id: vec3<u32>,
+        @builtin(workgroup_id) group_id: vec3<u32>) {
+    let tile = group_id.x + 1u;
+    // Inclusive scan of the tile totals, so the previous entry covers every
+    // tile before this one
+    let offset = tile_offsets[tile - 1u];
+    let base = tile * TILE_SIZE + local_id.x;
+    for (var i = 0u; i < ITEMS_PER_THREAD; i++) {
+        let index = base + i * WORKGROUP_SIZE;
+        if (index < params.count) {
+            data[index] = combine(offset, data[index]);
+        }
+    }
+}
@@ -1,6 +1,7 @@
 struct VertexInput {
     @location(0) position: vec2<f32>,
-    @location(1) color: vec3<f32>,
+    // Unorm8x4, see Vertex.hpp
+    @location(1) color: vec4<f32>,
 }
 
 ;
@@ -16,20 +17,44 @@ struct Uniforms {
     @location(0) dimensions: vec2<f32>,
 }
 
+// See ObjectTransform in TransformBuffer.hpp
+struct Transform {
+    basisX: vec2<f32>,
+    basisY: vec2<f32>,
+    translation: vec2<f32>,
+    // RGBA8, multiplies the vertex color
+    tint: u32,
+    padding: u32,
+}
+
 @group(0) @binding(0) var<uniform> uniforms: Uniforms;
+@group(0) @binding(1) var<storage, read> transforms: array<Transform>;
+
+fn transformVertex(model: VertexInput, object: u32) -> VertexOutput {
+    let transform = transforms[object];
+    let position = transform.basisX * model.position.x + transform.basisY * model.position.y + transform.translation;
 
-@vertex
-fn vertexMain(model: VertexInput) -> VertexOutput {
     var output: VertexOutput;
     // Convert from screen space (0,0 at top-left) to NDC (-1,-1 at bottom-left, 1,1 at top-right)
     // Screen space: x: [0, width], y: [0, height]
     // NDC: x: [-1, 1], y: [-1, 1]
-    let ndc_x = (model.position.x / uniforms.dimensions.x) * 2.0 - 1.0;
-    let ndc_y = 1.0 - (model.position.y / uniforms.dimensions.y) * 2.0;
+    let ndc_x = (position.x / uniforms.dimensions.x) * 2.0 - 1.0;
+    let ndc_y = 1.0 - (position.y / uniforms.dimensions.y) * 2.0;
     output.position = vec4f(ndc_x, ndc_y, 0.0, 1.0);
-    output.color = model.color;
+    output.color = model.color.rgb * unpack4x8unorm(transform.tint).rgb;
     return output;
+}
 
+// Single layers pass their transform slot as the first instance
+@vertex
+fn vertexMain(model: VertexInput, @builtin(instance_index) object: u32) -> VertexOutput {
+    return transformVertex(model, object);
+}
+
+// Batched draws carry the slot per vertex, see DrawBatcher
+@vertex
+fn vertexBatched(model: VertexInput, @location(2) object: u32) -> VertexOutput {
+    return transformVertex(model, object);
 }
 
 @fragment
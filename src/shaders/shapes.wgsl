@@ -0,0 +1,53 @@
+struct InstanceInput {
+    @location(0) center: vec2<f32>,
+    @location(1) halfSize: vec2<f32>,
+    @location(2) cornerRadius: f32,
+    @location(3) color: vec4<f32>,
+}
+
+struct VertexOutput {
+    @builtin(position) position: vec4<f32>,
+    // Position relative to the shape center, in pixels
+    @location(0) local: vec2<f32>,
+    @location(1) @interpolate(flat) halfSize: vec2<f32>,
+    @location(2) @interpolate(flat) cornerRadius: f32,
+    @location(3) @interpolate(flat) color: vec4<f32>,
+}
+
+struct Uniforms {
+    dimensions: vec2<f32>,
+}
+
+@group(0) @binding(0) var<uniform> uniforms: Uniforms;
+
+@vertex
+fn vertexMain(@builtin(vertex_index) vertexIndex: u32, shape: InstanceInput) -> VertexOutput {
+    // Triangle strip corners: (-1,-1), (1,-1), (-1,1), (1,1)
+    let corner = vec2f(f32(vertexIndex & 1u), f32(vertexIndex >> 1u)) * 2.0 - 1.0;
+    // Grow the quad by a pixel so the anti-aliased edge is not clipped
+    let local = corner * (shape.halfSize + vec2f(1.0));
+    let position = shape.center + local;
+
+    var output: VertexOutput;
+    // Same screen space to NDC mapping as default.wgsl
+    let ndc_x = (position.x / uniforms.dimensions.x) * 2.0 - 1.0;
+    let ndc_y = 1.0 - (position.y / uniforms.dimensions.y) * 2.0;
+    output.position = vec4f(ndc_x, ndc_y, 0.0, 1.0);
+    output.local = local;
+    output.halfSize = shape.halfSize;
+    output.cornerRadius = min(shape.cornerRadius, min(shape.halfSize.x, shape.halfSize.y));
+    output.color = shape.color;
+    return output;
+}
+
+@fragment
+fn fragmentMain(input: VertexOutput) -> @location(0) vec4f {
+    // Signed distance to a rounded rectangle, negative inside
+    let q = abs(input.local) - input.halfSize + vec2f(input.cornerRadius);
+    let distance = length(max(q, vec2f(0.0))) + min(max(q.x, q.y), 0.0) - input.cornerRadius;
+    let coverage = clamp(0.5 - distance, 0.0, 1.0);
+    if (coverage <= 0.0) {
+        discard;
+    }
+    return vec4f(input.color.rgb, input.color.a * coverage);
+}